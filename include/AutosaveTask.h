@@ -0,0 +1,35 @@
+﻿#ifndef AUTOSAVETASK_H
+#define AUTOSAVETASK_H
+
+#include "MycadWriter.h"
+#include <QThread>
+#include <QString>
+
+// 后台自动保存：把GUI线程取得的文档快照写成完整的 .mycad 文件，结束后由 finished() 信号通知GUI线程
+// 未加载的形状从快照记录的源文件中复制字节，源文件在任务结束前不会被替换
+class AutosaveTask : public QThread
+{
+    Q_OBJECT
+
+public:
+    AutosaveTask(const QString& filename, const MycadWriter::Snapshot& snapshot, quint64 revision,
+                 QObject* parent = nullptr);
+    ~AutosaveTask();
+
+    const QString& fileName() const { return m_fileName; }
+    quint64 revision() const { return m_revision; }
+
+    // 只在 finished() 之后读取
+    bool succeeded() const { return m_succeeded; }
+
+protected:
+    void run() override;
+
+private:
+    QString m_fileName;
+    MycadWriter::Snapshot m_snapshot;
+    quint64 m_revision;         // 取快照时文档的修改计数
+    bool m_succeeded;
+};
+
+#endif // AUTOSAVETASK_H
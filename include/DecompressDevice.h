@@ -0,0 +1,76 @@
+﻿#ifndef DECOMPRESSDEVICE_H
+#define DECOMPRESSDEVICE_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+// 压缩格式，按文件开头的魔数识别
+enum class Compression
+{
+    None,
+    Gzip,       // 1F 8B
+    Zstd        // 28 B5 2F FD
+};
+
+struct DecompressState;
+
+// 流式解压设备：按固定大小的块读取压缩文件并解压，只读、顺序访问
+// gzip 需要以 MYCAD_WITH_ZLIB 编译，zstd 需要以 MYCAD_WITH_ZSTD 编译，否则 open() 失败
+class DecompressDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit DecompressDevice(const QString& filename, QObject* parent = nullptr);
+    ~DecompressDevice() override;
+
+    // 读取文件开头的魔数
+    static Compression detect(const QString& filename);
+
+    // 解压文件开头，按内容识别负载格式（step / iges / stl / obj），无法识别时按去掉压缩后缀的文件名判断
+    static QString payloadFormat(const QString& filename);
+
+    Compression compression() const { return m_compression; }
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+    bool atEnd() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    bool refill();
+
+    QFile m_file;
+    Compression m_compression;
+    std::vector<char> m_input;      // 压缩数据缓冲区
+    qint64 m_inputPos;
+    qint64 m_inputSize;
+    bool m_inputEnd;                // 压缩文件已读完
+    bool m_frameComplete;           // 最后一个 gzip 成员 / zstd 帧已完整解压
+    bool m_end;                     // 解压数据已全部读出
+    std::unique_ptr<DecompressState> m_state;
+};
+
+// 把 QIODevice 包装为 std::istream 使用的缓冲区（用于只接受标准流的读取器）
+class DeviceStreamBuf : public std::streambuf
+{
+public:
+    explicit DeviceStreamBuf(QIODevice* device, size_t bufferSize = 1 << 16);
+
+protected:
+    int_type underflow() override;
+
+private:
+    QIODevice* m_device;
+    std::vector<char> m_buffer;
+};
+
+#endif // DECOMPRESSDEVICE_H
@@ -4,12 +4,25 @@
 #include <QObject>
 #include <QString>
 #include <QList>
+#include <QHash>
+#include <QByteArray>
+#include <memory>
 
+#include <Bnd_Box.hxx>
 #include <TopoDS_Shape.hxx>
+#include <TopLoc_Location.hxx>
 #include <AIS_Shape.hxx>
+#include <AIS_InteractiveObject.hxx>
+#include <Prs3d_Drawer.hxx>
 #include <TCollection_AsciiString.hxx>
 
+#include "MycadWriter.h"
+
 class View3D;
+class QFile;
+class QIODevice;
+class MycadCompactTask;
+class AutosaveTask;
 
 // 文档对象，管理所有3D对象
 class Document : public QObject
@@ -25,23 +38,62 @@ public:
     
     // 添加/移除形状
     void addShape(const TopoDS_Shape& shape, const QString& name = QString());
+    // 批量添加：所有对象显示后只刷新一次视图，documentChanged 只发送一次
+    void addShapes(const QList<TopoDS_Shape>& shapes, const QStringList& names = QStringList());
     void removeShape(int index);
     void removeShape(const QString& name);
+    // 批量移除：无效和重复的序号被忽略，其余对象保持原有顺序，只刷新一次视图
+    void removeShapes(const QList<int>& indices);
+    // 替换形状的几何，保留名称和位置；原显示对象被选中时新对象保持选中
+    void replaceShape(int index, const TopoDS_Shape& shape);
     int getShapeCount() const { return m_shapes.size(); }
     
-    // 获取形状
-    TopoDS_Shape getShape(int index) const;
-    TopoDS_Shape getShape(const QString& name) const;
+    // 批量更新：beginUpdate() 与 endUpdate() 之间的增删、替换只显示不刷新视图，
+    // 最外层的 endUpdate() 刷新一次视图并只发送一次 documentChanged；可以嵌套
+    void beginUpdate();
+    void endUpdate();
+    
+    // 获取形状：延迟加载的形状在第一次获取时从文件恢复
+    TopoDS_Shape getShape(int index);
+    TopoDS_Shape getShape(const QString& name);
     Handle(AIS_Shape) getAISShape(int index) const;
     Handle(AIS_Shape) getAISShape(const QString& name) const;
     
-    // 根据AIS对象查找索引
+    // 获取显示对象：B-rep形状为AIS_Shape，只带三角网格的形状为MeshVS_Mesh
+    Handle(AIS_InteractiveObject) getDisplayObject(int index) const;
+    bool isMeshShape(int index) const;
+    
+    // 根据AIS对象或名称查找索引（哈希查找，与对象数量无关）
     int findShapeIndex(Handle(AIS_Shape) aisShape) const;
+    int findObjectIndex(const Handle(AIS_InteractiveObject)& object) const;
+    int findShapeIndex(const QString& name) const;
+    
+    // 稳定ID：对象加入文档时分配，删除其他对象后不变，不会重复使用；0 表示无效
+    quint64 getShapeId(int index) const;
+    int findIndexById(quint64 id) const;
     
-    // 序列化
+    // 序列化：保存为版本6（目录 + 共享形状表 + 带三角网格的二进制BREP字节块 + 追加日志），可读取版本1（文本BREP）到版本5
+    // 引用同一 TShape 的形状只保存一次；保存时的剖分精度与当前显示设置一致时，打开后直接显示文件中的三角网格
+    // 打开版本3及以上的文件时只读取目录并映射文件，各形状先以包围盒线框占位，由 loadShapes() 分批或在需要时恢复几何
+    // 再次保存到打开或上次保存的版本6文件时只在末尾追加修改过的形状和删除记录，日志过大时在后台整理文件
     bool saveToFile(const QString& filename);
     bool loadFromFile(const QString& filename);
     
+    // 最近一次打开或保存的 .mycad 文件，新建或清空后为空
+    const QString& fileName() const { return m_fileName; }
+    
+    // 自动保存：在GUI线程复制形状句柄得到快照，由后台线程写成完整的版本6文件，编辑不受影响
+    // 自上次保存或自动保存以来没有修改、或上一次自动保存尚未结束时返回false；结束后发送 autosaveFinished
+    bool startAutosave(const QString& filename);
+    // 等待进行中的自动保存结束：后台线程读取文档形状的三角剖分，原地重新剖分文档形状
+    // （如导出时的 BRepMesh_IncrementalMesh）之前必须调用
+    void waitForAutosave();
+    
+    // 延迟加载：并行恢复指定形状的几何并替换占位显示，只刷新一次视图
+    void loadShapes(const QList<int>& indices);
+    bool isLoaded(int index) const;
+    int pendingCount() const;
+    
     // 获取所有形状名称
     QStringList getShapeNames() const;
     
@@ -51,15 +103,76 @@ signals:
     void shapeAdded(const QString& name);
     void shapeRemoved(const QString& name);
     void documentChanged();
+    void autosaveFinished(const QString& filename, bool ok);
+
+private slots:
+    void onCompactFinished();
+    void onAutosaveFinished();
 
 private:
     QList<TopoDS_Shape> m_shapes;
-    QList<Handle(AIS_Shape)> m_aisShapes;
+    QList<Handle(AIS_InteractiveObject)> m_aisObjects;
     QStringList m_shapeNames;
     View3D* m_view3D;
     
+    // 与上面的列表一一对应的稳定ID，以及由ID、名称和显示对象到ID的索引
+    QList<quint64> m_ids;
+    QHash<quint64, int> m_indexById;
+    QMultiHash<QString, quint64> m_idsByName;
+    QHash<const AIS_InteractiveObject*, quint64> m_idByObject;
+    quint64 m_nextObjectId;
+    void indexAppended();
+    
+    // 刷新视图并发送 documentChanged，批量更新期间推迟到 endUpdate()
+    int m_updateDepth;
+    bool m_changePending;
+    void notifyChanged();
+    
+    // 未加载形状在映射文件中的数据块，offset < 0 表示几何已在内存中
+    // 形状 = 数据块中的基础形状放到 location 并按 orientation 组合方向
+    struct StoredBlock
+    {
+        qint64 offset = -1;
+        qint64 size = 0;
+        Bnd_Box box;
+        bool meshed = false;    // 数据中的三角网格满足当前显示精度
+        TopLoc_Location location;
+        TopAbs_Orientation orientation = TopAbs_FORWARD;
+        quint32 record = 0;     // 在 m_fileName 中的记录号，0 表示尚未保存
+        bool dirty = true;      // 与文件中的记录不同，增量保存时需要写出
+    };
+    QList<StoredBlock> m_blocks;
+    std::unique_ptr<QFile> m_source;    // 延迟加载的数据来源
+    const uchar* m_sourceData;
+    QByteArray m_sourceBuffer;          // 无法映射文件时读入的全部数据
+    QHash<qint64, TopoDS_Shape> m_loadedBases;  // 已恢复且仍被未加载形状引用的基础形状，键为数据块位置
+    
+    // 增量保存：文件中日志的区间，版本6以外的文件 m_journalEnd 为0，下一次保存写出完整文件
+    QString m_fileName;
+    qint64 m_journalStart;
+    qint64 m_journalEnd;
+    quint32 m_nextRecord;
+    QList<quint32> m_removedRecords;    // 文件中有记录、已从文档删除的形状
+    MycadCompactTask* m_compactTask;
+    
+    // 修改计数：增删、替换形状时加一，与最近一次保存或自动保存时的值比较
+    AutosaveTask* m_autosaveTask;
+    quint64 m_revision;
+    quint64 m_autosavedRevision;
+    
     int m_nextId;
     QString generateName(const QString& prefix = "Shape");
+    Handle(AIS_InteractiveObject) createDisplayObject(const TopoDS_Shape& shape, bool meshed = false) const;
+    Handle(Prs3d_Drawer) viewerDrawer() const;
+    void appendShapes(const QList<TopoDS_Shape>& shapes, const QStringList& names,
+                      const QList<StoredBlock>& blocks);
+    void swapDisplayObject(int index, const Handle(AIS_InteractiveObject)& object);
+    bool openSource(const QString& filename);
+    void releaseSource();
+    bool appendJournal();
+    void startCompaction();
+    void discardCompaction();
+    MycadWriter::Snapshot takeSnapshot(bool changedOnly);
 };
 
 #endif // DOCUMENT_H
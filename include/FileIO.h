@@ -2,36 +2,108 @@
 #define FILEIO_H
 
 #include <QString>
+#include <QList>
 #include <TopoDS_Shape.hxx>
+#include <Message_ProgressRange.hxx>
+#include <functional>
+
+// 流式导入回调：在转换线程中调用，可能被多个线程同时调用
+using ImportPartCallback = std::function<void(const QString& filename, const TopoDS_Shape& part)>;
+
+// 导入选项
+struct ImportOptions
+{
+    bool stepAllRoots = true;   // STEP多根模式：转换全部根对象并合并为一个复合体
+    bool stepParallelParse = true;   // STEP：大文件使用并行解析前端（见 StepParser），不支持的文件回退到标准解析
+    qint64 stepParallelMinSize = qint64(32) << 20;  // STEP：启用并行解析的最小文件大小（字节），小文件分块收益有限
+    bool stlMeshOnly = true;    // STL网格模式：焊接顶点后存为单个三角网格，不生成逐三角形的面
+    bool useCache = true;       // STEP/IGES：使用转换结果缓存（见 TranslationCache）
+    double igesSewingTolerance = 0.01;  // IGES：散面缝合容差（模型单位），0表示不缝合
+    int threadCount = 0;        // 工作线程数，0表示使用全部逻辑核心
+    // 流式导入：设置后每个部件（STEP/IGES根对象，其他格式为整个结果）转换并剖分完成即回调，
+    // 返回的形状仍包含全部部件
+    ImportPartCallback partCallback;
+};
+
+// 批量导入中单个文件的结果
+struct ImportResult
+{
+    QString filename;
+    TopoDS_Shape shape;
+    bool success = false;
+    qint64 elapsedMs = 0;
+};
+
+// 剖分精度预设
+enum class MeshPreset
+{
+    Coarse,     // 粗糙：预览、快速交换
+    Standard,   // 标准
+    Fine        // 精细：打印、渲染
+};
+
+// 导出选项
+struct ExportOptions
+{
+    double linearDeflection = 0.1;  // 剖分线性偏差（模型单位）
+    double angularDeflection = 0.5; // 剖分角度偏差（弧度）
+    bool quantize = false;          // glTF：16位量化位置和法线（KHR_mesh_quantization）
+    bool stepInstancing = true;     // STEP：按装配写出，共享同一 TShape 的形状只写一次零件，其余作为带位置的实例
+    int threadCount = 0;            // 工作线程数，0表示使用全部逻辑核心
+};
 
 class FileIO
 {
 public:
-    // 导入文件
-    static bool importFile(const QString& filename, TopoDS_Shape& shape);
+    // 导入文件，progress 用于报告进度和响应取消（取消时返回false）
+    static bool importFile(const QString& filename, TopoDS_Shape& shape,
+                           const ImportOptions& options = ImportOptions(),
+                           const Message_ProgressRange& progress = Message_ProgressRange());
+    
+    // 批量导入：在有界工作线程池中同时转换多个文件，结果按输入顺序返回
+    // maxWorkers为0时取 min(文件数, 逻辑核心数)，核心在工作线程之间平分给各读取器的内部并行
+    static QList<ImportResult> importFiles(const QStringList& filenames,
+                                           const ImportOptions& options = ImportOptions(),
+                                           int maxWorkers = 0,
+                                           const Message_ProgressRange& progress = Message_ProgressRange());
     
     // 导出文件
-    static bool exportFile(const QString& filename, const TopoDS_Shape& shape);
+    static bool exportFile(const QString& filename, const TopoDS_Shape& shape,
+                           const ExportOptions& options = ExportOptions());
     
     // 获取支持的文件格式
     static QStringList getImportFormats();
     static QStringList getExportFormats();
     static QString getFileFilter(bool isImport);
+    static bool canImport(const QString& filename);
+    
+    // 剖分精度预设（用于STL/OBJ/glTF导出）
+    static QStringList getMeshPresetNames();
+    static void applyMeshPreset(ExportOptions& options, MeshPreset preset);
+    
+    // 解析工作线程数：0或负数表示使用全部逻辑核心
+    static int resolveThreadCount(int requested);
     
 private:
-    static bool importSTEP(const QString& filename, TopoDS_Shape& shape);
-    static bool importIGES(const QString& filename, TopoDS_Shape& shape);
-    static bool importSTL(const QString& filename, TopoDS_Shape& shape);
-    static bool importOBJ(const QString& filename, TopoDS_Shape& shape);
-    static bool importGLTF(const QString& filename, TopoDS_Shape& shape);
-    static bool importGLB(const QString& filename, TopoDS_Shape& shape);
-    
-    static bool exportSTEP(const QString& filename, const TopoDS_Shape& shape);
+    // 把一个部件交给 partCallback，mesh 为真时先按默认显示精度剖分，GUI线程显示时无需再剖分
+    static void deliverPart(const ImportOptions& options, const QString& filename, const TopoDS_Shape& part,
+                            bool mesh);
+    
+    static bool importSTEP(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options,
+                           const Message_ProgressRange& progress);
+    static bool importIGES(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options,
+                           const Message_ProgressRange& progress);
+    static bool importSTL(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options);
+    static bool importOBJ(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options);
+    static bool importGLTF(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options);
+    static bool importGLB(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options);
+    
+    static bool exportSTEP(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options);
     static bool exportIGES(const QString& filename, const TopoDS_Shape& shape);
-    static bool exportSTL(const QString& filename, const TopoDS_Shape& shape);
-    static bool exportOBJ(const QString& filename, const TopoDS_Shape& shape);
-    static bool exportGLTF(const QString& filename, const TopoDS_Shape& shape);
-    static bool exportGLB(const QString& filename, const TopoDS_Shape& shape);
+    static bool exportSTL(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options);
+    static bool exportOBJ(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options);
+    static bool exportGLTF(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options);
+    static bool exportGLB(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options);
 };
 
 #endif // FILEIO_H
@@ -0,0 +1,38 @@
+﻿#ifndef GLTFREADER_H
+#define GLTFREADER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <TopoDS_Shape.hxx>
+
+// 原生glTF 2.0读取器（.gltf / .glb）
+// 二进制缓冲区只映射一次，float32 的 POSITION 访问器直接作为三角网格的节点数组（零拷贝），
+// 各网格并行解码；同一网格被多个节点引用时共享同一个 TShape，只通过位置（Location）区分实例
+class GltfReader
+{
+public:
+    // 读取统计信息
+    struct Statistics
+    {
+        int nbMeshes = 0;           // 解码的网格数
+        int nbPrimitives = 0;       // 解码的图元数（仅三角形图元）
+        int nbInstances = 0;        // 场景中引用网格的节点数
+        int nbZeroCopy = 0;         // 节点数组直接映射的图元数
+        int nbTriangles = 0;        // 去重后的三角形总数
+        qint64 decodeMs = 0;        // 并行解码耗时
+    };
+
+    explicit GltfReader(int threadCount = 0);
+
+    bool read(const QString& filename);
+
+    TopoDS_Shape shape() const { return m_shape; }
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    int m_threadCount;
+    TopoDS_Shape m_shape;
+    Statistics m_stats;
+};
+
+#endif // GLTFREADER_H
@@ -0,0 +1,47 @@
+﻿#ifndef GLTFWRITER_H
+#define GLTFWRITER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <TopoDS_Shape.hxx>
+
+// glTF 2.0 导出器（.gltf / .glb）
+// 复合体中共享同一 TShape 的形状（如阵列项）只生成一个网格，通过多个带矩阵的节点实例化；
+// 唯一网格统一剖分一次后并行合并重复顶点，可选16位量化（KHR_mesh_quantization）；
+// 所有缓冲区的布局预先计算，JSON 和二进制数据一次顺序写出，不在内存中拼接整个缓冲区
+class GltfWriter
+{
+public:
+    // 导出统计信息
+    struct Statistics
+    {
+        int nbMeshes = 0;           // 写出的网格数（唯一 TShape）
+        int nbInstances = 0;        // 写出的节点数
+        int nbVertices = 0;         // 合并后的顶点总数
+        int nbTriangles = 0;        // 三角形总数
+        int nbMergedVertices = 0;   // 合并掉的重复顶点数
+        qint64 binaryBytes = 0;     // 二进制缓冲区字节数
+        qint64 meshMs = 0;          // 剖分与并行合并耗时
+        qint64 writeMs = 0;         // 写文件耗时
+    };
+
+    GltfWriter();
+
+    void setDeflection(double linear, double angular) { m_linearDeflection = linear; m_angularDeflection = angular; }
+    void setQuantization(bool enabled) { m_quantize = enabled; }
+    void setThreadCount(int count) { m_threadCount = count; }
+
+    // 按扩展名决定写 GLB（单文件）或 glTF（JSON + 同名 .bin）
+    bool write(const QString& filename, const TopoDS_Shape& shape, bool binary);
+
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    double m_linearDeflection;
+    double m_angularDeflection;
+    bool m_quantize;
+    int m_threadCount;
+    Statistics m_stats;
+};
+
+#endif // GLTFWRITER_H
@@ -0,0 +1,54 @@
+﻿#ifndef IGESREADER_H
+#define IGESREADER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <TopoDS_Shape.hxx>
+#include <Message_ProgressRange.hxx>
+#include <functional>
+
+// IGES导入流水线：解析 -> 按根实体分区并行转换 -> 并行修复面 -> 缝合
+// 转换得到的全部形状都会保留（而不只是第一个），供应商提供的散面经缝合后成为壳
+// 并行转换的限制：各线程共享实体图但各有一个 TransientProcess；根实体引用同一几何实体时
+// 只用一个线程，以免生成互不共享的重复形状
+class IgesReader
+{
+public:
+    // 各阶段统计信息
+    struct Statistics
+    {
+        int nbRoots = 0;            // 可转换的根实体数
+        int nbShapes = 0;           // 转换成功的形状数
+        int nbWorkers = 0;          // 转换线程数
+        bool sharedEntities = false;    // 根实体共享几何实体，退回单线程转换
+        int nbFaces = 0;            // 面数
+        int nbFreeEdges = 0;        // 缝合后的自由边数
+        bool parallelFix = false;   // 面修复是否并行执行（面之间共享边时退回串行）
+        qint64 readMs = 0;          // 解析耗时
+        qint64 transferMs = 0;      // 转换耗时
+        qint64 fixMs = 0;           // 面修复耗时
+        qint64 sewMs = 0;           // 缝合耗时
+    };
+
+    explicit IgesReader(int threadCount = 0);
+
+    // 缝合容差（模型单位），tolerance <= 0 时不缝合
+    void setSewingTolerance(double tolerance) { m_sewingTolerance = tolerance; }
+
+    // 部件回调：不需要缝合的结果在转换线程中转换完即回调，缝合得到的壳在缝合后回调
+    void setPartCallback(const std::function<void(const TopoDS_Shape&)>& callback) { m_partCallback = callback; }
+
+    bool read(const QString& filename, const Message_ProgressRange& progress = Message_ProgressRange());
+
+    TopoDS_Shape shape() const { return m_shape; }
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    int m_threadCount;
+    double m_sewingTolerance;
+    std::function<void(const TopoDS_Shape&)> m_partCallback;
+    TopoDS_Shape m_shape;
+    Statistics m_stats;
+};
+
+#endif // IGESREADER_H
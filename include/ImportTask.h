@@ -0,0 +1,83 @@
+﻿#ifndef IMPORTTASK_H
+#define IMPORTTASK_H
+
+#include "FileIO.h"
+#include <QThread>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QHash>
+#include <Message_ProgressIndicator.hxx>
+#include <atomic>
+
+// 导入进度：由转换线程更新进度位置，GUI线程定时读取；取消标志通过 UserBreak() 传给OCCT转换器
+class ImportProgress : public Message_ProgressIndicator
+{
+    DEFINE_STANDARD_RTTI_INLINE(ImportProgress, Message_ProgressIndicator)
+
+public:
+    ImportProgress() : m_percent(0), m_cancelled(false) {}
+
+    int percent() const { return m_percent; }
+    void cancel() { m_cancelled = true; }
+    bool isCancelled() const { return m_cancelled; }
+
+    Standard_Boolean UserBreak() override { return m_cancelled; }
+
+protected:
+    void Show(const Message_ProgressScope& /*scope*/, const Standard_Boolean /*force*/) override
+    {
+        m_percent = int(GetPosition() * 100.0);
+    }
+
+private:
+    std::atomic<int> m_percent;
+    std::atomic<bool> m_cancelled;
+};
+
+// 流式导入中已完成转换、等待显示的部件
+struct ImportPart
+{
+    QString filename;
+    int index = 0;              // 在所属文件中的序号（从1开始）
+    TopoDS_Shape shape;
+};
+
+// 后台导入任务：在独立线程中调用 FileIO::importFiles，结束后由 finished() 信号通知GUI线程取结果
+// 流式模式下转换线程把完成的部件放入队列，GUI线程定时用 takeParts() 取走显示
+class ImportTask : public QThread
+{
+    Q_OBJECT
+
+public:
+    ImportTask(const QStringList& filenames, const ImportOptions& options, bool streaming = false,
+               QObject* parent = nullptr);
+    ~ImportTask();
+
+    const QStringList& filenames() const { return m_filenames; }
+    int progress() const { return m_progress->percent(); }
+    void cancel() { m_progress->cancel(); }
+    bool isCancelled() const { return m_progress->isCancelled(); }
+    bool isStreaming() const { return m_streaming; }
+
+    // 取走目前已完成的部件（可在任务运行中调用）
+    QList<ImportPart> takeParts();
+
+    // 只在 finished() 之后读取
+    const QList<ImportResult>& results() const { return m_results; }
+
+protected:
+    void run() override;
+
+private:
+    QStringList m_filenames;
+    ImportOptions m_options;
+    bool m_streaming;
+    Handle(ImportProgress) m_progress;
+    QList<ImportResult> m_results;
+    QMutex m_partsMutex;
+    QList<ImportPart> m_parts;
+    QHash<QString, int> m_partCounts;
+};
+
+#endif // IMPORTTASK_H
@@ -0,0 +1,80 @@
+﻿#ifndef LAZYSTEPASSEMBLY_H
+#define LAZYSTEPASSEMBLY_H
+
+#include <QString>
+#include <QtGlobal>
+#include <Bnd_Box.hxx>
+#include <Standard_Transient.hxx>
+#include <TopoDS_Shape.hxx>
+#include <gp_Trsf.hxx>
+#include <memory>
+#include <vector>
+
+class STEPControl_Reader;
+
+// STEP装配的延迟加载：打开时只解析文件并建立装配结构（零件、实例变换、包围盒），
+// 零件几何在第一次需要时才转换；同一零件的多个实例共享同一个 TShape
+class LazyStepAssembly
+{
+public:
+    // 零件（没有子装配的产品定义）
+    struct Part
+    {
+        QString name;
+        Handle(Standard_Transient) definition;  // StepBasic_ProductDefinition
+        Bnd_Box box;                            // 按控制点估算的包围盒（零件坐标系）
+        TopoDS_Shape shape;                     // 已转换的几何，未加载时为空
+        bool loaded = false;
+    };
+
+    // 零件在装配中的一次引用
+    struct Instance
+    {
+        int part = -1;
+        QString name;           // 装配路径
+        gp_Trsf trsf;           // 相对于根装配的变换
+    };
+
+    struct Statistics
+    {
+        int nbProducts = 0;         // 产品定义数
+        int nbParts = 0;            // 零件数
+        int nbInstances = 0;        // 零件实例数
+        int nbLoadedParts = 0;      // 已转换的零件数
+        qint64 parseMs = 0;         // 解析文件耗时
+        qint64 structureMs = 0;     // 建立装配结构耗时
+        qint64 boxMs = 0;           // 估算包围盒耗时
+        qint64 transferMs = 0;      // 已转换零件的累计耗时
+    };
+
+    LazyStepAssembly();
+    ~LazyStepAssembly();
+
+    bool open(const QString& filename);
+
+    const QString& filename() const { return m_filename; }
+    int partCount() const { return int(m_parts.size()); }
+    int instanceCount() const { return int(m_instances.size()); }
+    const Part& part(int index) const { return m_parts[index]; }
+    const Instance& instance(int index) const { return m_instances[index]; }
+
+    // 实例的占位形状（按包围盒生成的长方体，已放到实例位置）
+    TopoDS_Shape placeholder(int instance) const;
+
+    // 实例的几何：零件未加载时先转换，结果已放到实例位置；失败时返回空形状
+    TopoDS_Shape loadInstance(int instance);
+
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    bool loadPart(int index);
+
+    QString m_filename;
+    std::unique_ptr<STEPControl_Reader> m_reader;
+    std::vector<Part> m_parts;
+    std::vector<Instance> m_instances;
+    std::vector<TopoDS_Shape> m_placeholders;   // 每个零件一个，实例共享
+    Statistics m_stats;
+};
+
+#endif // LAZYSTEPASSEMBLY_H
@@ -13,10 +13,17 @@
 #include <QComboBox>
 #include <QLabel>
 #include <QGroupBox>
+#include <QProgressBar>
+#include <QTimer>
+#include <QHash>
+#include <TopoDS_Shape.hxx>
+#include <memory>
 
 class View3D;
 class Document;
 class SelectionManager;
+class ImportTask;
+class LazyStepAssembly;
 
 class MainWindow : public QMainWindow
 {
@@ -26,11 +33,19 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    // 拖放导入
+    void dragEnterEvent(QDragEnterEvent* event) override;
+    void dropEvent(QDropEvent* event) override;
+
 private slots:
     // 文件操作
     void onImportFile();
     void onExportFile();
     void onSaveFile();
+    void onSaveFileAs();
+    void onAutosave();
+    void onAutosaveFinished(const QString& filename, bool ok);
     void onOpenFile();
     void onNewFile();
     
@@ -65,6 +80,18 @@ private slots:
     
     // 鼠标拾取
     void onPickPoint();
+    
+    // 后台导入
+    void onImportProgress();
+    void onImportFinished();
+    void onCancelImport();
+    
+    // STEP装配延迟加载：选中占位对象时转换零件几何
+    void onImportStepLazy();
+    void onViewSelectionChanged();
+    
+    // 打开 .mycad 文档后在空闲时分批恢复占位形状的几何
+    void onRestoreShapes();
 
 private:
     void setupUI();
@@ -73,6 +100,23 @@ private:
     void setupDockWidgets();
     void connectSignals();
     
+    // 在后台线程批量导入文件；流式模式下部件转换完即显示，否则完成后一次性加入文档
+    void importFiles(const QStringList& filenames);
+    
+    // 把流式导入中已完成的部件加入文档，返回本次加入的数量
+    int addStreamedParts(ImportTask* task);
+    
+    // 自动保存文件：应用数据目录下按进程号区分
+    QString autosavePath() const;
+    
+    // 延迟加载的零件实例：把指定序号中的占位对象转换为实际几何，全部成功时返回true
+    bool loadLazyInstances(const QList<int>& indices, int& nbLoaded);
+    // 保存、导出前调用：有实例无法转换时提示并返回false，不能把占位长方体当作几何写出
+    bool resolveLazyInstances(const QList<int>& indices);
+    // 文档中是否还有未转换的占位对象（同时清理已删除或已替换的记录）
+    bool hasLazyPlaceholders();
+    QList<int> allShapeIndices() const;
+    
     View3D* m_view3D;
     Document* m_document;
     SelectionManager* m_selectionManager;
@@ -80,6 +124,25 @@ private:
     // UI组件
     QComboBox* m_selectionFilterCombo;
     QLabel* m_statusLabel;
+    QProgressBar* m_importProgressBar;
+    QPushButton* m_cancelImportButton;
+    QTimer* m_importTimer;
+    ImportTask* m_importTask;
+    QAction* m_streamImportAction;
+    QAction* m_stepParallelParseAction;
+    int m_streamedParts;        // 当前导入中已显示的部件数
+    QTimer* m_autosaveTimer;    // 定时自动保存到 autosavePath()
+    QTimer* m_restoreTimer;     // 打开文档后分批恢复几何，每次触发处理一批
+    int m_restoreNext;          // 下一批恢复的起始序号
+    
+    // 延迟加载的实例：文档中占位形状的稳定ID -> 装配和实例序号
+    struct LazyInstance
+    {
+        std::shared_ptr<LazyStepAssembly> assembly;
+        int instance = -1;
+        TopoDS_Shape placeholder;
+    };
+    QHash<quint64, LazyInstance> m_lazyInstances;
 };
 
 #endif // MAINWINDOW_H
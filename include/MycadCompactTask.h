@@ -0,0 +1,38 @@
+﻿#ifndef MYCADCOMPACTTASK_H
+#define MYCADCOMPACTTASK_H
+
+#include <QThread>
+#include <QString>
+#include <QHash>
+
+// 后台整理 .mycad 文件：把日志回放后的内容写入临时文件，结束后由 finished() 信号通知GUI线程替换原文件
+// 整理期间原文件仍可追加日志，GUI线程发现日志末尾已变化时丢弃整理结果
+class MycadCompactTask : public QThread
+{
+    Q_OBJECT
+
+public:
+    MycadCompactTask(const QString& filename, qint64 journalEnd, QObject* parent = nullptr);
+    ~MycadCompactTask();
+
+    const QString& fileName() const { return m_fileName; }
+    QString targetName() const { return m_fileName + ".compact"; }
+    qint64 journalEnd() const { return m_journalEnd; }
+
+    // 只在 finished() 之后读取
+    bool succeeded() const { return m_succeeded; }
+    const QHash<qint64, qint64>& offsets() const { return m_offsets; }
+    qint64 fileSize() const { return m_fileSize; }
+
+protected:
+    void run() override;
+
+private:
+    QString m_fileName;
+    qint64 m_journalEnd;
+    bool m_succeeded;
+    QHash<qint64, qint64> m_offsets;    // 旧数据块位置 -> 新位置
+    qint64 m_fileSize;
+};
+
+#endif // MYCADCOMPACTTASK_H
@@ -0,0 +1,105 @@
+﻿#ifndef MYCADFILE_H
+#define MYCADFILE_H
+
+#include <QString>
+#include <QHash>
+#include <QtGlobal>
+#include <Bnd_Box.hxx>
+#include <TopAbs_Orientation.hxx>
+#include <TopLoc_Location.hxx>
+#include <vector>
+
+class QDataStream;
+class QIODevice;
+
+// .mycad 文件结构：版本3起文件开头带目录，形状数据按块保存；版本6在数据块之后追加日志，
+// 增量保存只追加新增、修改和删除的记录。这里只处理目录、日志和数据块的位置，不恢复几何，
+// 由 Document 和后台整理任务共用
+class MycadFile
+{
+public:
+    // 文件格式版本
+    static constexpr quint32 FORMAT_TEXT = 1;       // 文本BREP转QString
+    static constexpr quint32 FORMAT_BINARY = 2;     // 二进制BREP字节块
+    static constexpr quint32 FORMAT_INDEXED = 3;    // 开头带目录（名称、包围盒、数据位置），支持延迟加载
+    static constexpr quint32 FORMAT_MESHED = 4;     // 目录中记录显示用三角网格的剖分精度
+    static constexpr quint32 FORMAT_SHARED = 5;     // 共享形状表：同一 TShape 只保存一次
+    static constexpr quint32 FORMAT_JOURNAL = 6;    // 形状带记录号，数据块之后为追加日志
+
+    // 数据块标志：带有满足显示精度的完整三角网格
+    static constexpr quint8 FLAG_MESHED = 0x01;
+
+    // 日志记录类型
+    enum RecordType : quint8
+    {
+        RECORD_DATA = 1,        // 数据块：字节数 + 二进制BREP
+        RECORD_PUT = 2,         // 新增或替换形状，引用文件中的数据块
+        RECORD_REMOVE = 3       // 删除形状
+    };
+
+    // 数据块表中的一项
+    struct Block
+    {
+        quint8 flags = 0;
+        qint64 offset = 0;
+        qint64 size = 0;
+    };
+
+    // 形状：数据块中的基础形状放到 location 并按 orientation 组合方向
+    struct Entry
+    {
+        quint32 record = 0;     // 文件内唯一的记录号
+        QString name;
+        Bnd_Box box;            // 放到位置后的包围盒
+        quint8 flags = 0;
+        qint64 offset = 0;      // 数据块位置和字节数（读取时）
+        qint64 size = 0;
+        int block = -1;         // 数据块表中的序号（写入时）
+        TopLoc_Location location;
+        TopAbs_Orientation orientation = TopAbs_FORWARD;
+    };
+
+    // 回放日志后的目录
+    struct Index
+    {
+        quint32 version = 0;
+        double deviationCoefficient = 0.0;
+        double deviationAngle = 0.0;
+        std::vector<Entry> entries;     // 按文档顺序
+        qint64 journalStart = 0;        // 日志区间（版本6），没有日志时两者都为文件末尾
+        qint64 journalEnd = 0;
+        int nbJournalRecords = 0;
+        quint32 nextRecord = 1;
+    };
+
+    // 读取版本3~6的目录并回放日志；版本不支持或文件已损坏时返回false
+    static bool readIndex(QIODevice& device, Index& index);
+
+    // 写入版本6的文件头和目录；各项长度只取决于名称和位置，写完数据后可用相同的表原位重写
+    static void writeDirectory(QDataStream& out, qint64 journalStart, qint64 journalEnd,
+                               double deviationCoefficient, double deviationAngle,
+                               const std::vector<Block>& blocks, const std::vector<Entry>& entries);
+
+    // 日志记录；数据块记录之后由调用方写入 size 字节的数据
+    static void writeDataRecord(QDataStream& out, qint64 size);
+    static void writePutRecord(QDataStream& out, const Entry& entry);
+    static void writeRemoveRecord(QDataStream& out, quint32 record);
+
+    // 提交日志：追加的记录写完后更新文件头中的日志末尾，未提交的记录在读取时被忽略
+    static bool commitJournal(QIODevice& device, qint64 journalEnd);
+
+    // 整理：把回放后仍在使用的数据块复制到新文件（同一数据块只复制一次），日志清空
+    // 源文件的日志末尾与 expectedJournalEnd 不同时放弃；offsets 返回旧数据块位置到新位置的映射
+    static bool compact(const QString& source, const QString& target, qint64 expectedJournalEnd,
+                        QHash<qint64, qint64>& offsets, qint64& fileSize);
+
+    // 包围盒按定长的6个double保存，空包围盒保存为最小值大于最大值
+    static void writeBox(QDataStream& out, const Bnd_Box& box);
+    static void readBox(QDataStream& in, Bnd_Box& box);
+
+    // 位置按 3x4 变换矩阵保存，单位变换只写一个标志
+    static void writeLocation(QDataStream& out, const TopLoc_Location& location);
+    static bool readLocation(QDataStream& in, TopLoc_Location& location);
+};
+
+#endif // MYCADFILE_H
@@ -0,0 +1,67 @@
+﻿#ifndef MYCADWRITER_H
+#define MYCADWRITER_H
+
+#include "MycadFile.h"
+#include <QString>
+#include <QHash>
+#include <TopoDS_Shape.hxx>
+#include <vector>
+
+class QIODevice;
+
+// 写出 .mycad 版本6文件的形状数据：引用同一 TShape 的形状只保存一次，数据块由工作线程并行序列化
+// 只读取快照中的形状，不访问 Document，可在后台线程使用
+class MycadWriter
+{
+public:
+    // 快照中的一个形状：已加载的几何，或源文件中尚未加载的数据块
+    struct Item
+    {
+        int index = -1;             // 取快照时在文档中的序号
+        TopoDS_Shape shape;         // 为空时按 stored 中的数据块、位置和方向保存
+        MycadFile::Entry stored;    // 记录号和名称；未加载时还有数据块位置、标志、包围盒、位置和方向
+    };
+
+    // 文档内容的快照：形状句柄与文档共享几何，在GUI线程复制句柄即可得到，不复制几何数据
+    struct Snapshot
+    {
+        std::vector<Item> items;
+        QHash<qint64, TopoDS_Shape> loadedBases;    // 已恢复的基础形状，键为源文件中的数据块位置
+        QString sourceName;                         // 未加载形状的数据来源
+        double deviationCoefficient = 0.0;          // 检查三角网格是否满足显示精度
+        double deviationAngle = 0.0;
+    };
+
+    MycadWriter();
+
+    // 写出完整文件（日志为空），未加载的数据块从 sourceData（源文件的内存映射）复制字节
+    bool write(QIODevice& file, const Snapshot& snapshot, const uchar* sourceData);
+
+    // 从 file 的当前位置追加日志：新的基础形状写为数据记录，每个形状写一条 PUT 记录
+    // 未加载的形状直接引用 stored 中的数据块，要求源文件就是 file
+    bool appendRecords(QIODevice& file, const Snapshot& snapshot);
+
+    // 写入后的结果：与快照中的形状一一对应的目录项（数据块位置已更新），
+    // 数据块表和各数据块的基础形状（直接复制字节的数据块为空）
+    const std::vector<MycadFile::Entry>& entries() const { return m_entries; }
+    const std::vector<MycadFile::Block>& blocks() const { return m_blocks; }
+    const std::vector<TopoDS_Shape>& bases() const { return m_bases; }
+    int threadCount() const { return m_threadCount; }
+
+    // 由基础形状得到放到指定位置和方向的实例，与基础形状共享 TShape
+    static TopoDS_Shape placeInstance(const TopoDS_Shape& base, const TopLoc_Location& location,
+                                      TopAbs_Orientation orientation);
+
+private:
+    void collect(const Snapshot& snapshot, bool copyStored);
+    bool writeBlocks(QIODevice& file, const Snapshot& snapshot, const uchar* sourceData, bool asRecords);
+
+    std::vector<MycadFile::Entry> m_entries;
+    std::vector<MycadFile::Block> m_blocks;
+    std::vector<TopoDS_Shape> m_bases;
+    std::vector<Bnd_Box> m_baseBoxes;
+    std::vector<qint64> m_sourceOffsets;    // 直接复制的数据块在源文件中的位置
+    int m_threadCount;
+};
+
+#endif // MYCADWRITER_H
@@ -0,0 +1,49 @@
+﻿#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <Poly_Triangulation.hxx>
+
+class QIODevice;
+
+// 原生OBJ读取器：内存映射文件，按块并行解析顶点和面，直接生成 Poly_Triangulation
+// 只读取几何（v / f），纹理坐标、法线、材质等信息被忽略
+class ObjReader
+{
+public:
+    // 读取统计信息
+    struct Statistics
+    {
+        qint64 fileSize = 0;        // 文件大小（字节）
+        int nbChunks = 0;           // 并行解析的块数
+        int nbNodes = 0;            // 顶点数
+        int nbTriangles = 0;        // 三角形数（多边形按扇形剖分）
+        int nbInvalidFaces = 0;     // 索引越界的三角形数（以退化三角形代替）
+        qint64 peakBytes = 0;       // 解析缓冲区与三角网格同时存在时的堆内存峰值（不含映射页）
+        qint64 parseMs = 0;         // 并行解析耗时
+        qint64 buildMs = 0;         // 生成三角网格耗时
+    };
+
+    explicit ObjReader(int threadCount = 0);
+
+    bool read(const QString& filename);
+
+    // 从顺序设备（如解压流）按块读取并分批并行解析，name 只用于日志
+    bool read(QIODevice& device, const QString& name);
+
+    Handle(Poly_Triangulation) triangulation() const { return m_triangulation; }
+    const Statistics& statistics() const { return m_stats; }
+
+    // 给定顶点数和三角形数时的内存上限估计（解析缓冲区 + 单精度三角网格）
+    static qint64 memoryBound(qint64 nbNodes, qint64 nbTriangles);
+
+private:
+    void logStatistics(const QString& filename) const;
+
+    int m_threadCount;
+    Handle(Poly_Triangulation) m_triangulation;
+    Statistics m_stats;
+};
+
+#endif // OBJREADER_H
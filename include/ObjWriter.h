@@ -0,0 +1,46 @@
+﻿#ifndef OBJWRITER_H
+#define OBJWRITER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <TopoDS_Shape.hxx>
+
+// 流式OBJ导出器
+// 面按批次在工作线程中格式化为文本缓冲区，再按原始顺序通过一个缓冲输出写入磁盘；
+// 同时最多存在两个批次（一个在格式化，一个在写出），内存占用与模型大小无关
+class ObjWriter
+{
+public:
+    // 导出统计信息
+    struct Statistics
+    {
+        int nbFaces = 0;            // 写出的面数
+        int nbBatches = 0;          // 批次数
+        qint64 nbVertices = 0;      // 顶点总数
+        qint64 nbTriangles = 0;     // 三角形总数
+        qint64 bytesWritten = 0;    // 写出的字节数
+        qint64 peakWindowBytes = 0; // 文本缓冲区的峰值占用
+        qint64 meshMs = 0;          // 剖分耗时
+        qint64 writeMs = 0;         // 格式化与写出耗时
+    };
+
+    ObjWriter();
+
+    void setDeflection(double linear, double angular) { m_linearDeflection = linear; m_angularDeflection = angular; }
+    void setThreadCount(int count) { m_threadCount = count; }
+    // 每个批次的文本缓冲区上限（字节），实际窗口为两个批次
+    void setWindowSize(qint64 bytes) { m_windowSize = bytes; }
+
+    bool write(const QString& filename, const TopoDS_Shape& shape);
+
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    double m_linearDeflection;
+    double m_angularDeflection;
+    int m_threadCount;
+    qint64 m_windowSize;
+    Statistics m_stats;
+};
+
+#endif // OBJWRITER_H
@@ -0,0 +1,15 @@
+﻿#ifndef SHAREDGRAPHSESSION_H
+#define SHAREDGRAPHSESSION_H
+
+#include <XSControl_WorkSession.hxx>
+#include <Interface_HGraph.hxx>
+
+// 并行转换用的会话：SetModel() 之后引用主读取器已建好的实体图，
+// 各工作线程不再为整个模型分别建图；图在转换期间只被读取
+class SharedGraphSession : public XSControl_WorkSession
+{
+public:
+    void shareGraph(const Handle(Interface_HGraph)& graph) { thegraph = graph; }
+};
+
+#endif // SHAREDGRAPHSESSION_H
@@ -0,0 +1,43 @@
+﻿#ifndef STEPPARSER_H
+#define STEPPARSER_H
+
+#include <QString>
+#include <QtGlobal>
+
+class STEPControl_Reader;
+
+// 并行STEP前端：内存映射文件，在实体边界处把 DATA 段切成若干块并行词法/语法分析，
+// 再按文件顺序合并为 StepData_StepReaderData，由OCCT完成实体识别并装入 reader 的会话
+// 只支持常见的 Part 21 子集（单个 DATA 段、无 SCOPE 和值实例），不支持时返回false，调用方回退到 ReadFile
+class StepParser
+{
+public:
+    // 解析统计信息
+    struct Statistics
+    {
+        qint64 fileSize = 0;        // 文件大小（字节）
+        int nbChunks = 0;           // DATA 段分块数
+        int nbRecords = 0;          // 记录数（含子列表）
+        qint64 nbParams = 0;        // 参数数
+        qint64 lexMs = 0;           // 并行分析耗时
+        qint64 mergeMs = 0;         // 合并记录耗时
+        qint64 loadMs = 0;          // 识别实体并装入模型耗时
+    };
+
+    explicit StepParser(int threadCount = 0);
+
+    // 解析文件并把模型装入 reader 的会话，成功后可直接调用 TransferRoots 等接口
+    bool read(const QString& filename, STEPControl_Reader& reader);
+
+    const Statistics& statistics() const { return m_stats; }
+
+    // 性能对比：分别用 STEPControl_Reader::ReadFile 和本前端解析同一文件，
+    // 输出耗时并逐个比较实体类型，结果一致时返回true
+    static bool benchmark(const QString& filename, int threadCount = 0);
+
+private:
+    int m_threadCount;
+    Statistics m_stats;
+};
+
+#endif // STEPPARSER_H
@@ -0,0 +1,50 @@
+﻿#ifndef STLREADER_H
+#define STLREADER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <Poly_Triangulation.hxx>
+
+class QIODevice;
+class QElapsedTimer;
+
+// 原生STL读取器：内存映射文件，按坐标哈希并行焊接重复顶点，生成单个 Poly_Triangulation
+// 与 StlAPI_Reader 不同，不为每个三角形创建 B-rep 面
+class StlReader
+{
+public:
+    // 读取统计信息
+    struct Statistics
+    {
+        qint64 fileSize = 0;        // 文件大小（字节）
+        bool binary = false;        // 是否为二进制STL
+        int nbTriangles = 0;        // 三角形数
+        int nbNodes = 0;            // 焊接后的顶点数
+        int nbDegenerate = 0;       // 焊接后出现重复顶点的三角形数
+        int nbPartitions = 0;       // 焊接哈希分区数
+        qint64 parseMs = 0;         // 解析与哈希耗时
+        qint64 weldMs = 0;          // 焊接耗时
+        qint64 buildMs = 0;         // 生成三角网格耗时
+    };
+
+    explicit StlReader(int threadCount = 0);
+
+    bool read(const QString& filename);
+
+    // 从顺序设备（如解压流）按块读取，name 只用于日志
+    bool read(QIODevice& device, const QString& name);
+
+    Handle(Poly_Triangulation) triangulation() const { return m_triangulation; }
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    // 焊接顶点并生成三角网格，顶点坐标为每个三角形连续的9个float，三角形之间间隔 triangleStride 字节
+    Handle(Poly_Triangulation) weld(const char* base, size_t triangleStride, qint64 nbTriangles, QElapsedTimer& timer);
+    void logStatistics(const QString& filename) const;
+
+    int m_threadCount;
+    Handle(Poly_Triangulation) m_triangulation;
+    Statistics m_stats;
+};
+
+#endif // STLREADER_H
@@ -0,0 +1,40 @@
+﻿#ifndef STLWRITER_H
+#define STLWRITER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <TopoDS_Shape.hxx>
+
+// 二进制STL导出器
+// 并行剖分后按面预先计算每个面在文件中的偏移，工作线程直接把三角形记录填入映射的输出文件，一次写完
+class StlWriter
+{
+public:
+    // 导出统计信息
+    struct Statistics
+    {
+        int nbFaces = 0;            // 写出的面数
+        qint64 nbTriangles = 0;     // 三角形总数
+        qint64 bytesWritten = 0;    // 文件大小
+        bool mapped = false;        // 是否直接写入映射的输出文件
+        qint64 meshMs = 0;          // 剖分耗时
+        qint64 writeMs = 0;         // 填充与写出耗时
+    };
+
+    StlWriter();
+
+    void setDeflection(double linear, double angular) { m_linearDeflection = linear; m_angularDeflection = angular; }
+    void setThreadCount(int count) { m_threadCount = count; }
+
+    bool write(const QString& filename, const TopoDS_Shape& shape);
+
+    const Statistics& statistics() const { return m_stats; }
+
+private:
+    double m_linearDeflection;
+    double m_angularDeflection;
+    int m_threadCount;
+    Statistics m_stats;
+};
+
+#endif // STLWRITER_H
@@ -0,0 +1,58 @@
+﻿#ifndef TRANSLATIONCACHE_H
+#define TRANSLATIONCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QtGlobal>
+#include <TopoDS_Shape.hxx>
+#include <atomic>
+
+struct ImportOptions;
+
+// 转换结果缓存：以文件内容哈希 + 转换设置为键，将转换后的形状以 BinTools 二进制 BRep 存在磁盘上
+// 命中时导入只需一次二进制读取；总大小超过上限时按最近使用时间淘汰
+// 所有方法可在多个导入线程中同时调用
+class TranslationCache
+{
+public:
+    static TranslationCache& instance();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    void setDirectory(const QString& directory);
+    QString directory() const;
+
+    // 缓存总大小上限（字节），默认 2GB
+    void setMaxBytes(qint64 bytes) { m_maxBytes = bytes; }
+    qint64 maxBytes() const { return m_maxBytes; }
+
+    // 计算缓存键；读取文件失败时返回空
+    QByteArray key(const QString& filename, const ImportOptions& options) const;
+
+    // 查找缓存，命中时更新最近使用时间
+    bool lookup(const QByteArray& key, TopoDS_Shape& shape);
+    // 写入缓存，写入后按需淘汰旧条目
+    bool store(const QByteArray& key, const TopoDS_Shape& shape);
+
+    void clear();
+
+    qint64 hits() const { return m_hits; }
+    qint64 misses() const { return m_misses; }
+
+private:
+    TranslationCache();
+
+    QString entryPath(const QByteArray& key) const;
+    void evict();
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    std::atomic<bool> m_enabled;
+    std::atomic<qint64> m_maxBytes;
+    std::atomic<qint64> m_hits;
+    std::atomic<qint64> m_misses;
+};
+
+#endif // TRANSLATIONCACHE_H
@@ -0,0 +1,43 @@
+﻿#ifndef TRIANGULATIONDATASOURCE_H
+#define TRIANGULATIONDATASOURCE_H
+
+#include <MeshVS_DataSource.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TColStd_PackedMapOfInteger.hxx>
+
+// 把单个 Poly_Triangulation 作为 MeshVS 数据源，用于只有网格的对象（STL/OBJ 等）的显示和选择
+// 坐标和法线直接从三角网格读取，不额外复制节点数组
+class TriangulationDataSource : public MeshVS_DataSource
+{
+    DEFINE_STANDARD_RTTI_INLINE(TriangulationDataSource, MeshVS_DataSource)
+
+public:
+    explicit TriangulationDataSource(const Handle(Poly_Triangulation)& triangulation);
+
+    Handle(Poly_Triangulation) triangulation() const { return m_triangulation; }
+
+    Standard_Boolean GetGeom(const Standard_Integer ID, const Standard_Boolean IsElement,
+                             TColStd_Array1OfReal& Coords, Standard_Integer& NbNodes,
+                             MeshVS_EntityType& Type) const override;
+
+    Standard_Boolean GetGeomType(const Standard_Integer ID, const Standard_Boolean IsElement,
+                                 MeshVS_EntityType& Type) const override;
+
+    Standard_Address GetAddr(const Standard_Integer ID, const Standard_Boolean IsElement) const override;
+
+    Standard_Boolean GetNodesByElement(const Standard_Integer ID, TColStd_Array1OfInteger& NodeIDs,
+                                       Standard_Integer& NbNodes) const override;
+
+    const TColStd_PackedMapOfInteger& GetAllNodes() const override { return m_nodes; }
+    const TColStd_PackedMapOfInteger& GetAllElements() const override { return m_elements; }
+
+    Standard_Boolean GetNormal(const Standard_Integer Id, const Standard_Integer Max,
+                               Standard_Real& nx, Standard_Real& ny, Standard_Real& nz) const override;
+
+private:
+    Handle(Poly_Triangulation) m_triangulation;
+    TColStd_PackedMapOfInteger m_nodes;
+    TColStd_PackedMapOfInteger m_elements;
+};
+
+#endif // TRIANGULATIONDATASOURCE_H
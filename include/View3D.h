@@ -44,6 +44,10 @@ public:
     // 鼠标拾取
     void pickPoint(const QPoint& pos);
 
+signals:
+    // 鼠标点选或框选完成
+    void selectionChanged();
+
 protected:
     QPaintEngine* paintEngine() const override;
     void paintEvent(QPaintEvent* event) override;
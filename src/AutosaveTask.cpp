@@ -0,0 +1,67 @@
+﻿#include "AutosaveTask.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+AutosaveTask::AutosaveTask(const QString& filename, const MycadWriter::Snapshot& snapshot, quint64 revision,
+                           QObject* parent)
+    : QThread(parent)
+    , m_fileName(filename)
+    , m_snapshot(snapshot)
+    , m_revision(revision)
+    , m_succeeded(false)
+{
+}
+
+AutosaveTask::~AutosaveTask()
+{
+    // 只写自动保存文件，退出时等待写完即可
+    wait();
+}
+
+void AutosaveTask::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+    
+    // 有未加载的形状时映射源文件，无法映射时整体读入
+    bool needsSource = false;
+    for (const MycadWriter::Item& item : m_snapshot.items) {
+        if (item.shape.IsNull() && !m_snapshot.loadedBases.contains(item.stored.offset)) {
+            needsSource = true;
+            break;
+        }
+    }
+    QFile source(m_snapshot.sourceName);
+    QByteArray sourceBuffer;
+    const uchar* sourceData = nullptr;
+    if (needsSource && source.open(QIODevice::ReadOnly)) {
+        sourceData = source.map(0, source.size());
+        if (sourceData == nullptr) {
+            sourceBuffer = source.readAll();
+            sourceData = reinterpret_cast<const uchar*>(sourceBuffer.constData());
+        }
+    }
+    
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    MycadWriter writer;
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "AutosaveTask::run() - 无法写入:" << m_fileName << file.errorString();
+    } else if (!writer.write(file, m_snapshot, sourceData)) {
+        file.cancelWriting();
+    } else {
+        m_succeeded = file.commit();
+    }
+    
+    if (sourceData != nullptr && sourceBuffer.isEmpty()) {
+        source.unmap(const_cast<uchar*>(sourceData));
+    }
+    
+    qDebug() << "AutosaveTask::run() -" << m_fileName << (m_succeeded ? "完成" : "失败")
+             << "形状:" << m_snapshot.items.size() << "数据块:" << writer.blocks().size()
+             << "耗时(ms):" << timer.elapsed();
+}
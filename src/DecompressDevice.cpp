@@ -0,0 +1,325 @@
+﻿#include "DecompressDevice.h"
+#include <QFileInfo>
+#include <QDebug>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+
+#ifdef MYCAD_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef MYCAD_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+// 每次从压缩文件读取的块大小
+const qint64 THE_INPUT_BLOCK = 256 * 1024;
+
+// 识别负载格式时解压的字节数
+const qint64 THE_PAYLOAD_PROBE = 4096;
+
+const unsigned char THE_GZIP_MAGIC[] = { 0x1F, 0x8B };
+const unsigned char THE_ZSTD_MAGIC[] = { 0x28, 0xB5, 0x2F, 0xFD };
+
+// 按文件开头的内容判断格式
+QString detectPayload(const QByteArray& head)
+{
+    int start = 0;
+    while (start < head.size() && std::isspace(static_cast<unsigned char>(head[start]))) {
+        ++start;
+    }
+    const QByteArray text = head.mid(start);
+    if (text.startsWith("ISO-10303-21")) {
+        return "step";
+    }
+    // IGES：80列定长记录，第73列为段标识，开始段为 S
+    const int lineEnd = head.indexOf('\n');
+    if (lineEnd >= 73 && head[72] == 'S') {
+        return "iges";
+    }
+    if (text.startsWith("solid")) {
+        return "stl";
+    }
+    // OBJ：跳过注释，第一条语句为常见关键字
+    for (const QByteArray& line : text.split('\n')) {
+        const QByteArray trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+            continue;
+        }
+        static const char* const THE_OBJ_KEYWORDS[] = { "v ", "vt ", "vn ", "f ", "o ", "g ", "s ", "mtllib ", "usemtl " };
+        for (const char* keyword : THE_OBJ_KEYWORDS) {
+            if (trimmed.startsWith(keyword)) {
+                return "obj";
+            }
+        }
+        break;
+    }
+    return QString();
+}
+
+} // namespace
+
+// 解压器状态，按编译时启用的库保存 zlib / zstd 的流对象
+struct DecompressState
+{
+#ifdef MYCAD_WITH_ZLIB
+    z_stream zlib;
+    bool zlibInitialized = false;
+#endif
+#ifdef MYCAD_WITH_ZSTD
+    ZSTD_DStream* zstd = nullptr;
+#endif
+
+    ~DecompressState()
+    {
+#ifdef MYCAD_WITH_ZLIB
+        if (zlibInitialized) {
+            inflateEnd(&zlib);
+        }
+#endif
+#ifdef MYCAD_WITH_ZSTD
+        if (zstd != nullptr) {
+            ZSTD_freeDStream(zstd);
+        }
+#endif
+    }
+};
+
+DecompressDevice::DecompressDevice(const QString& filename, QObject* parent)
+    : QIODevice(parent)
+    , m_file(filename)
+    , m_compression(Compression::None)
+    , m_inputPos(0)
+    , m_inputSize(0)
+    , m_inputEnd(false)
+    , m_frameComplete(false)
+    , m_end(false)
+{
+}
+
+DecompressDevice::~DecompressDevice()
+{
+    close();
+}
+
+Compression DecompressDevice::detect(const QString& filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return Compression::None;
+    }
+    const QByteArray magic = file.read(4);
+    if (magic.size() >= 2 && std::memcmp(magic.constData(), THE_GZIP_MAGIC, 2) == 0) {
+        return Compression::Gzip;
+    }
+    if (magic.size() >= 4 && std::memcmp(magic.constData(), THE_ZSTD_MAGIC, 4) == 0) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+QString DecompressDevice::payloadFormat(const QString& filename)
+{
+    DecompressDevice device(filename);
+    QString format;
+    if (device.open(QIODevice::ReadOnly)) {
+        format = detectPayload(device.read(THE_PAYLOAD_PROBE));
+    }
+    if (format.isEmpty()) {
+        // 二进制STL等没有特征的内容：按 part.stl.gz 中的内层后缀判断
+        format = QFileInfo(QFileInfo(filename).completeBaseName()).suffix().toLower();
+        if (format == "stp") {
+            format = "step";
+        } else if (format == "igs") {
+            format = "iges";
+        }
+    }
+    return format;
+}
+
+bool DecompressDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || !(mode & QIODevice::ReadOnly)) {
+        setErrorString("只支持只读打开");
+        return false;
+    }
+    m_compression = detect(m_file.fileName());
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    m_state.reset(new DecompressState());
+    bool ready = false;
+    switch (m_compression) {
+    case Compression::Gzip:
+#ifdef MYCAD_WITH_ZLIB
+        std::memset(&m_state->zlib, 0, sizeof(m_state->zlib));
+        // 15 + 32：自动识别 gzip / zlib 头
+        ready = inflateInit2(&m_state->zlib, 15 + 32) == Z_OK;
+        m_state->zlibInitialized = ready;
+#else
+        setErrorString("未启用 gzip 解压支持（需要 zlib）");
+#endif
+        break;
+    case Compression::Zstd:
+#ifdef MYCAD_WITH_ZSTD
+        m_state->zstd = ZSTD_createDStream();
+        ready = m_state->zstd != nullptr && !ZSTD_isError(ZSTD_initDStream(m_state->zstd));
+#else
+        setErrorString("未启用 zstd 解压支持（需要 libzstd）");
+#endif
+        break;
+    case Compression::None:
+        setErrorString("不是 gzip 或 zstd 压缩文件");
+        break;
+    }
+    if (!ready) {
+        m_state.reset();
+        m_file.close();
+        return false;
+    }
+
+    m_input.resize(size_t(THE_INPUT_BLOCK));
+    m_inputPos = 0;
+    m_inputSize = 0;
+    m_inputEnd = false;
+    m_frameComplete = false;
+    m_end = false;
+    return QIODevice::open(mode);
+}
+
+void DecompressDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    QIODevice::close();
+    m_state.reset();
+    m_file.close();
+    std::vector<char>().swap(m_input);
+}
+
+bool DecompressDevice::atEnd() const
+{
+    return m_end && QIODevice::atEnd();
+}
+
+bool DecompressDevice::refill()
+{
+    if (m_inputPos < m_inputSize) {
+        return true;
+    }
+    if (m_inputEnd) {
+        return false;
+    }
+    m_inputSize = m_file.read(m_input.data(), qint64(m_input.size()));
+    m_inputPos = 0;
+    if (m_inputSize <= 0) {
+        m_inputSize = 0;
+        m_inputEnd = true;
+        return false;
+    }
+    return true;
+}
+
+qint64 DecompressDevice::readData(char* data, qint64 maxSize)
+{
+    if (m_end || m_state == nullptr) {
+        return 0;
+    }
+
+    qint64 produced = 0;
+    while (produced == 0 && maxSize > 0) {
+        if (!refill()) {
+            if (!m_frameComplete) {
+                qWarning() << "DecompressDevice::readData() - 压缩文件不完整:" << m_file.fileName();
+            }
+            m_end = true;
+            return 0;
+        }
+
+        const qint64 available = m_inputSize - m_inputPos;
+        const qint64 capacity = std::min<qint64>(maxSize, UINT_MAX);
+        if (m_compression == Compression::Gzip) {
+#ifdef MYCAD_WITH_ZLIB
+            z_stream& stream = m_state->zlib;
+            stream.next_in = reinterpret_cast<Bytef*>(m_input.data() + m_inputPos);
+            stream.avail_in = uInt(std::min<qint64>(available, UINT_MAX));
+            stream.next_out = reinterpret_cast<Bytef*>(data);
+            stream.avail_out = uInt(capacity);
+            const int status = inflate(&stream, Z_NO_FLUSH);
+            const qint64 consumed = qint64(stream.next_in - reinterpret_cast<Bytef*>(m_input.data() + m_inputPos));
+            m_inputPos += consumed;
+            produced = capacity - qint64(stream.avail_out);
+            if (status == Z_STREAM_END) {
+                // 多成员 gzip：重置后继续解压下一个成员
+                m_frameComplete = true;
+                inflateReset(&stream);
+            } else if (status == Z_OK || status == Z_BUF_ERROR) {
+                if (consumed > 0 || produced > 0) {
+                    m_frameComplete = false;
+                }
+            } else if (m_frameComplete && produced == 0) {
+                // 完整成员之后的填充字节
+                m_end = true;
+                return 0;
+            } else {
+                setErrorString(QString("gzip 解压失败: %1").arg(stream.msg ? stream.msg : ""));
+                qWarning() << "DecompressDevice::readData() -" << errorString() << m_file.fileName();
+                m_end = true;
+                return produced > 0 ? produced : -1;
+            }
+#endif
+        } else if (m_compression == Compression::Zstd) {
+#ifdef MYCAD_WITH_ZSTD
+            ZSTD_inBuffer in = { m_input.data() + m_inputPos, size_t(available), 0 };
+            ZSTD_outBuffer out = { data, size_t(capacity), 0 };
+            const size_t status = ZSTD_decompressStream(m_state->zstd, &out, &in);
+            if (ZSTD_isError(status)) {
+                setErrorString(QString("zstd 解压失败: %1").arg(ZSTD_getErrorName(status)));
+                qWarning() << "DecompressDevice::readData() -" << errorString() << m_file.fileName();
+                m_end = true;
+                return out.pos > 0 ? qint64(out.pos) : -1;
+            }
+            m_inputPos += qint64(in.pos);
+            produced = qint64(out.pos);
+            // 返回0表示当前帧已完整解压，后续输入属于下一帧
+            if (status == 0) {
+                m_frameComplete = true;
+            } else if (in.pos > 0 || out.pos > 0) {
+                m_frameComplete = false;
+            }
+#endif
+        }
+    }
+    return produced;
+}
+
+qint64 DecompressDevice::writeData(const char* /*data*/, qint64 /*maxSize*/)
+{
+    return -1;
+}
+
+DeviceStreamBuf::DeviceStreamBuf(QIODevice* device, size_t bufferSize)
+    : m_device(device)
+    , m_buffer(bufferSize)
+{
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+}
+
+DeviceStreamBuf::int_type DeviceStreamBuf::underflow()
+{
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    const qint64 count = m_device->read(m_buffer.data(), qint64(m_buffer.size()));
+    if (count <= 0) {
+        return traits_type::eof();
+    }
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + count);
+    return traits_type::to_int_type(*gptr());
+}
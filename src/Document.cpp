@@ -1,7 +1,23 @@
 ﻿#include "Document.h"
 #include "View3D.h"
+#include "TriangulationDataSource.h"
+#include "MycadFile.h"
+#include "MycadWriter.h"
+#include "AutosaveTask.h"
+#include "MycadCompactTask.h"
 #include <AIS_Shape.hxx>
 #include <Prs3d_Drawer.hxx>
+#include <MeshVS_Mesh.hxx>
+#include <MeshVS_MeshPrsBuilder.hxx>
+#include <MeshVS_Drawer.hxx>
+#include <MeshVS_DrawerAttribute.hxx>
+#include <MeshVS_DisplayModeFlags.hxx>
+#include <BRep_Tool.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopLoc_Location.hxx>
+#include <TopAbs.hxx>
+#include <gp_Trsf.hxx>
 #include <QFile>
 #include <QDataStream>
 #include <QFileInfo>
@@ -10,12 +26,123 @@
 #include <BRep_Builder.hxx>
 #include <TopoDS_Compound.hxx>
 #include <BRepTools.hxx>
+#include <BinTools.hxx>
 #include <Standard_Failure.hxx>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QSaveFile>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <OSD_Parallel.hxx>
+#include <algorithm>
+#include <cmath>
 #include <exception>
+#include <istream>
+#include <streambuf>
+#include <vector>
+
+namespace {
+
+// 只带三角网格、没有曲面的面（STL/OBJ等网格导入的结果）
+Handle(Poly_Triangulation) meshOnlyTriangulation(const TopoDS_Shape& shape, TopLoc_Location& location)
+{
+    if (shape.ShapeType() != TopAbs_FACE) {
+        return Handle(Poly_Triangulation)();
+    }
+    const TopoDS_Face& face = TopoDS::Face(shape);
+    TopLoc_Location surfaceLocation;
+    if (!BRep_Tool::Surface(face, surfaceLocation).IsNull()) {
+        return Handle(Poly_Triangulation)();
+    }
+    return BRep_Tool::Triangulation(face, location);
+}
+
+// 增量保存后日志超过此大小且超过基础部分的四分之一时，在后台整理文件
+const qint64 THE_COMPACT_MIN_JOURNAL = 1 << 20;
+
+// 未加载形状的占位：包围盒长方体，没有包围盒时为空复合体
+TopoDS_Shape placeholderShape(const Bnd_Box& box)
+{
+    if (!box.IsVoid()) {
+        Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+        box.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+        // 平面形状的包围盒可能退化，按对角线放大一点
+        const Standard_Real gap = std::max(1.0e-3, 1.0e-3 * std::sqrt(box.SquareExtent()));
+        try {
+            return BRepPrimAPI_MakeBox(gp_Pnt(xMin, yMin, zMin),
+                                       gp_Pnt(std::max(xMax, xMin + gap), std::max(yMax, yMin + gap),
+                                              std::max(zMax, zMin + gap))).Shape();
+        } catch (const Standard_Failure& e) {
+            qWarning() << "Document - 无法生成占位形状:" << e.GetMessageString();
+        }
+    }
+    TopoDS_Compound compound;
+    BRep_Builder().MakeCompound(compound);
+    return compound;
+}
+
+// 在内存中的字节块上读取形状，供多个线程各自独立使用
+// BinTools 读取共享子形状时会按位置跳转，需要支持定位
+class MemoryBuf : public std::streambuf
+{
+public:
+    MemoryBuf(const char* data, qint64 size)
+    {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode mode) override
+    {
+        if (!(mode & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        off_type base = 0;
+        if (dir == std::ios_base::cur) {
+            base = gptr() - eback();
+        } else if (dir == std::ios_base::end) {
+            base = egptr() - eback();
+        }
+        const off_type target = base + offset;
+        if (target < 0 || target > egptr() - eback()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + target, egptr());
+        return pos_type(target);
+    }
+    
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override
+    {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+};
+
+// 一个形状的名称、序列化数据和恢复结果
+struct ShapeBlock
+{
+    QString name;
+    const char* data = nullptr;     // 指向文件映射或 storage
+    qint64 size = 0;
+    QByteArray storage;             // 无法映射文件或旧版本时保存数据副本
+    TopoDS_Shape shape;
+};
+
+} // namespace
 
 Document::Document(QObject* parent)
     : QObject(parent)
     , m_view3D(nullptr)
+    , m_nextObjectId(1)
+    , m_updateDepth(0)
+    , m_changePending(false)
+    , m_sourceData(nullptr)
+    , m_journalStart(0)
+    , m_journalEnd(0)
+    , m_nextRecord(1)
+    , m_compactTask(nullptr)
+    , m_autosaveTask(nullptr)
+    , m_revision(0)
+    , m_autosavedRevision(0)
     , m_nextId(1)
 {
 }
@@ -29,20 +156,33 @@ void Document::clear()
 {
     if (m_view3D && !m_view3D->getContext().IsNull()) {
         Handle(AIS_InteractiveContext) context = m_view3D->getContext();
-        for (auto& aisShape : m_aisShapes) {
-            if (!aisShape.IsNull()) {
-                context->Remove(aisShape, Standard_False);
+        for (auto& aisObject : m_aisObjects) {
+            if (!aisObject.IsNull()) {
+                context->Remove(aisObject, Standard_False);
             }
         }
-        context->UpdateCurrentViewer();
     }
     
     m_shapes.clear();
-    m_aisShapes.clear();
+    m_aisObjects.clear();
     m_shapeNames.clear();
+    m_blocks.clear();
+    m_ids.clear();
+    m_indexById.clear();
+    m_idsByName.clear();
+    m_idByObject.clear();
+    m_loadedBases.clear();
+    releaseSource();
+    discardCompaction();
+    m_fileName.clear();
+    m_journalStart = 0;
+    m_journalEnd = 0;
+    m_nextRecord = 1;
+    m_removedRecords.clear();
+    m_autosavedRevision = ++m_revision;
     m_nextId = 1;
     
-    emit documentChanged();
+    notifyChanged();
 }
 
 void Document::addShape(const TopoDS_Shape& shape, const QString& name)
@@ -59,19 +199,15 @@ void Document::addShape(const TopoDS_Shape& shape, const QString& name)
     
     m_shapes.append(shape);
     m_shapeNames.append(shapeName);
+    m_blocks.append(StoredBlock());
+    ++m_revision;
     qDebug() << "Document::addShape() - 形状已添加到列表";
     
     qDebug() << "Document::addShape() - 创建AIS显示对象";
     // 创建AIS显示对象
-    Handle(AIS_Shape) aisShape = new AIS_Shape(shape);
-    // 使用 Shaded 模式
-    aisShape->SetDisplayMode(AIS_Shaded);
-    // 启用面的边界线显示，实现着色带边效果
-    Handle(Prs3d_Drawer) drawer = aisShape->Attributes();
-    if (!drawer.IsNull()) {
-        drawer->SetFaceBoundaryDraw(Standard_True);
-    }
-    m_aisShapes.append(aisShape);
+    Handle(AIS_InteractiveObject) aisShape = createDisplayObject(shape);
+    m_aisObjects.append(aisShape);
+    indexAppended();
     qDebug() << "Document::addShape() - AIS对象创建完成";
     
     // 添加到视图（参考 occQt.cpp 的实现方式，直接调用 Display()）
@@ -80,11 +216,11 @@ void Document::addShape(const TopoDS_Shape& shape, const QString& name)
         qDebug() << "Document::addShape() - AIS对象指针:" << (void*)aisShape.get();
         qDebug() << "Document::addShape() - 上下文指针:" << (void*)m_view3D->getContext().get();
         
-        // 参考 occQt.cpp 中的实现：直接调用 Display(Standard_True)
-        // Standard_True 表示立即更新视图
+        // 参考 occQt.cpp 中的实现：直接调用 Display()，视图在 notifyChanged() 中刷新
+        // （批量更新期间推迟到 endUpdate()）
         try {
-            qDebug() << "Document::addShape() - 调用 Display(Standard_True)";
-            m_view3D->getContext()->Display(aisShape, Standard_True);
+            qDebug() << "Document::addShape() - 调用 Display(Standard_False)";
+            m_view3D->getContext()->Display(aisShape, Standard_False);
             qDebug() << "Document::addShape() - Display() 成功";
         } catch (const Standard_Failure& e) {
             qWarning() << "Document::addShape() - OpenCascade异常:" << e.GetMessageString();
@@ -99,120 +235,607 @@ void Document::addShape(const TopoDS_Shape& shape, const QString& name)
     
     qDebug() << "Document::addShape() - 发送信号";
     emit shapeAdded(shapeName);
-    emit documentChanged();
+    notifyChanged();
     qDebug() << "Document::addShape() - 完成";
 }
 
+void Document::addShapes(const QList<TopoDS_Shape>& shapes, const QStringList& names)
+{
+    appendShapes(shapes, names, QList<StoredBlock>());
+}
+
+void Document::appendShapes(const QList<TopoDS_Shape>& shapes, const QStringList& names,
+                            const QList<StoredBlock>& blocks)
+{
+    Handle(AIS_InteractiveContext) context;
+    if (m_view3D && !m_view3D->getContext().IsNull()) {
+        context = m_view3D->getContext();
+    }
+    
+    QStringList added;
+    for (int i = 0; i < shapes.size(); ++i) {
+        const TopoDS_Shape& shape = shapes[i];
+        if (shape.IsNull()) {
+            continue;
+        }
+        
+        QString shapeName = (i < names.size() && !names[i].isEmpty()) ? names[i] : generateName();
+        const StoredBlock block = i < blocks.size() ? blocks[i] : StoredBlock();
+        Handle(AIS_InteractiveObject) aisObject = createDisplayObject(shape, block.offset < 0 && block.meshed);
+        if (block.offset >= 0) {
+            // 未加载的形状以包围盒线框占位
+            aisObject->SetDisplayMode(AIS_WireFrame);
+        }
+        m_shapes.append(shape);
+        m_shapeNames.append(shapeName);
+        m_aisObjects.append(aisObject);
+        m_blocks.append(block.offset >= 0 ? block : StoredBlock());
+        indexAppended();
+        added.append(shapeName);
+        
+        if (!context.IsNull()) {
+            try {
+                context->Display(aisObject, Standard_False);
+            } catch (const Standard_Failure& e) {
+                qWarning() << "Document::addShapes() - OpenCascade异常:" << shapeName << e.GetMessageString();
+            } catch (const std::exception& e) {
+                qWarning() << "Document::addShapes() - 标准异常:" << shapeName << e.what();
+            } catch (...) {
+                qWarning() << "Document::addShapes() - 未知异常:" << shapeName;
+            }
+        }
+    }
+    
+    if (added.isEmpty()) {
+        return;
+    }
+    ++m_revision;
+    qDebug() << "Document::addShapes() - 添加形状:" << added.size();
+    
+    for (const QString& name : added) {
+        emit shapeAdded(name);
+    }
+    notifyChanged();
+}
+
 void Document::removeShape(int index)
 {
-    if (index < 0 || index >= m_shapes.size()) {
+    removeShapes(QList<int>() << index);
+}
+
+void Document::removeShapes(const QList<int>& indices)
+{
+    std::vector<char> removed(size_t(m_shapes.size()), 0);
+    int nbRemoved = 0;
+    for (int index : indices) {
+        if (index >= 0 && index < m_shapes.size() && !removed[size_t(index)]) {
+            removed[size_t(index)] = 1;
+            ++nbRemoved;
+        }
+    }
+    if (nbRemoved == 0) {
         return;
     }
     
-    QString name = m_shapeNames[index];
+    Handle(AIS_InteractiveContext) context;
+    if (m_view3D && !m_view3D->getContext().IsNull()) {
+        context = m_view3D->getContext();
+    }
+    
+    // 一次遍历把保留的对象前移，各列表和索引只整理一次，相对顺序不变
+    QStringList names;
+    int kept = 0;
+    for (int i = 0; i < m_shapes.size(); ++i) {
+        const quint64 id = m_ids[i];
+        if (removed[size_t(i)]) {
+            // 从视图移除，刷新在 notifyChanged() 中进行
+            const Handle(AIS_InteractiveObject)& object = m_aisObjects[i];
+            if (!object.IsNull()) {
+                if (!context.IsNull()) {
+                    context->Remove(object, Standard_False);
+                }
+                m_idByObject.remove(object.get());
+            }
+            // 已保存过的形状在下次增量保存时写出删除记录
+            if (m_blocks[i].record != 0) {
+                m_removedRecords.append(m_blocks[i].record);
+            }
+            m_indexById.remove(id);
+            m_idsByName.remove(m_shapeNames[i], id);
+            names.append(m_shapeNames[i]);
+            continue;
+        }
+        if (kept != i) {
+            m_shapes[kept] = m_shapes[i];
+            m_aisObjects[kept] = m_aisObjects[i];
+            m_shapeNames[kept] = m_shapeNames[i];
+            m_blocks[kept] = m_blocks[i];
+            m_ids[kept] = id;
+            m_indexById[id] = kept;
+        }
+        ++kept;
+    }
+    m_shapes.erase(m_shapes.begin() + kept, m_shapes.end());
+    m_aisObjects.erase(m_aisObjects.begin() + kept, m_aisObjects.end());
+    m_shapeNames.erase(m_shapeNames.begin() + kept, m_shapeNames.end());
+    m_blocks.erase(m_blocks.begin() + kept, m_blocks.end());
+    m_ids.erase(m_ids.begin() + kept, m_ids.end());
+    ++m_revision;
     
-    // 从视图移除
-    if (m_view3D && !m_view3D->getContext().IsNull() && !m_aisShapes[index].IsNull()) {
-        m_view3D->getContext()->Remove(m_aisShapes[index], Standard_False);
+    for (const QString& name : names) {
+        emit shapeRemoved(name);
+    }
+    notifyChanged();
+}
+
+void Document::beginUpdate()
+{
+    ++m_updateDepth;
+}
+
+void Document::endUpdate()
+{
+    if (m_updateDepth == 0) {
+        return;
+    }
+    if (--m_updateDepth == 0 && m_changePending) {
+        m_changePending = false;
+        notifyChanged();
+    }
+}
+
+void Document::notifyChanged()
+{
+    if (m_updateDepth > 0) {
+        m_changePending = true;
+        return;
+    }
+    if (m_view3D && !m_view3D->getContext().IsNull()) {
         m_view3D->getContext()->UpdateCurrentViewer();
     }
+    emit documentChanged();
+}
+
+void Document::replaceShape(int index, const TopoDS_Shape& shape)
+{
+    if (index < 0 || index >= m_shapes.size() || shape.IsNull()) {
+        return;
+    }
     
-    m_shapes.removeAt(index);
-    m_aisShapes.removeAt(index);
-    m_shapeNames.removeAt(index);
+    // 保留记录号，增量保存时替换文件中的同一条记录
+    StoredBlock block;
+    block.record = m_blocks[index].record;
+    m_shapes[index] = shape;
+    m_blocks[index] = block;
+    ++m_revision;
+    swapDisplayObject(index, createDisplayObject(shape));
+    notifyChanged();
+}
+
+void Document::swapDisplayObject(int index, const Handle(AIS_InteractiveObject)& object)
+{
+    Handle(AIS_InteractiveObject) oldObject = m_aisObjects[index];
+    m_aisObjects[index] = object;
+    if (!oldObject.IsNull()) {
+        m_idByObject.remove(oldObject.get());
+    }
+    if (!object.IsNull()) {
+        m_idByObject.insert(object.get(), m_ids[index]);
+    }
     
-    emit shapeRemoved(name);
-    emit documentChanged();
+    if (m_view3D && !m_view3D->getContext().IsNull()) {
+        Handle(AIS_InteractiveContext) context = m_view3D->getContext();
+        const bool selected = !oldObject.IsNull() && context->IsSelected(oldObject);
+        if (!oldObject.IsNull()) {
+            context->Remove(oldObject, Standard_False);
+        }
+        try {
+            context->Display(object, Standard_False);
+            if (selected) {
+                context->AddOrRemoveSelected(object, Standard_False);
+            }
+        } catch (const Standard_Failure& e) {
+            qWarning() << "Document::swapDisplayObject() - OpenCascade异常:" << e.GetMessageString();
+        }
+    }
 }
 
 void Document::removeShape(const QString& name)
 {
-    int index = m_shapeNames.indexOf(name);
+    int index = findShapeIndex(name);
     if (index >= 0) {
         removeShape(index);
     }
 }
 
-TopoDS_Shape Document::getShape(int index) const
+quint64 Document::getShapeId(int index) const
 {
-    if (index >= 0 && index < m_shapes.size()) {
-        return m_shapes[index];
+    return index >= 0 && index < m_ids.size() ? m_ids[index] : 0;
+}
+
+int Document::findIndexById(quint64 id) const
+{
+    return m_indexById.value(id, -1);
+}
+
+int Document::findShapeIndex(const QString& name) const
+{
+    // 重名时与按列表查找一致，返回最靠前的一个
+    int index = -1;
+    for (auto it = m_idsByName.constFind(name); it != m_idsByName.constEnd() && it.key() == name; ++it) {
+        const int candidate = m_indexById.value(it.value(), -1);
+        if (candidate >= 0 && (index < 0 || candidate < index)) {
+            index = candidate;
+        }
     }
-    return TopoDS_Shape();
+    return index;
 }
 
-TopoDS_Shape Document::getShape(const QString& name) const
+TopoDS_Shape Document::getShape(int index)
 {
-    int index = m_shapeNames.indexOf(name);
-    if (index >= 0) {
+    if (index >= 0 && index < m_shapes.size()) {
+        if (m_blocks[index].offset >= 0) {
+            loadShapes(QList<int>() << index);
+        }
         return m_shapes[index];
     }
     return TopoDS_Shape();
 }
 
+TopoDS_Shape Document::getShape(const QString& name)
+{
+    return getShape(findShapeIndex(name));
+}
+
 Handle(AIS_Shape) Document::getAISShape(int index) const
 {
-    if (index >= 0 && index < m_aisShapes.size()) {
-        return m_aisShapes[index];
-    }
-    return Handle(AIS_Shape)();
+    // 网格对象不是AIS_Shape，返回空句柄
+    return Handle(AIS_Shape)::DownCast(getDisplayObject(index));
 }
 
 Handle(AIS_Shape) Document::getAISShape(const QString& name) const
 {
-    int index = m_shapeNames.indexOf(name);
-    if (index >= 0) {
-        return m_aisShapes[index];
+    return getAISShape(findShapeIndex(name));
+}
+
+Handle(AIS_InteractiveObject) Document::getDisplayObject(int index) const
+{
+    if (index >= 0 && index < m_aisObjects.size()) {
+        return m_aisObjects[index];
     }
-    return Handle(AIS_Shape)();
+    return Handle(AIS_InteractiveObject)();
+}
+
+bool Document::isMeshShape(int index) const
+{
+    return !Handle(MeshVS_Mesh)::DownCast(getDisplayObject(index)).IsNull();
 }
 
 int Document::findShapeIndex(Handle(AIS_Shape) aisShape) const
 {
-    if (aisShape.IsNull()) {
+    return findObjectIndex(aisShape);
+}
+
+int Document::findObjectIndex(const Handle(AIS_InteractiveObject)& object) const
+{
+    if (object.IsNull()) {
         return -1;
     }
+    auto it = m_idByObject.constFind(object.get());
+    return it != m_idByObject.constEnd() ? findIndexById(it.value()) : -1;
+}
+
+void Document::indexAppended()
+{
+    const int index = m_shapes.size() - 1;
+    const quint64 id = m_nextObjectId++;
+    m_ids.append(id);
+    m_indexById.insert(id, index);
+    m_idsByName.insert(m_shapeNames[index], id);
+    if (!m_aisObjects[index].IsNull()) {
+        m_idByObject.insert(m_aisObjects[index].get(), id);
+    }
+}
+
+bool Document::saveToFile(const QString& filename)
+{
+    // 再次保存到已绑定的版本6文件时只追加日志；文件已被其他程序修改或追加失败时写出完整文件
+    if (!m_fileName.isEmpty() && QFileInfo(filename) == QFileInfo(m_fileName) && appendJournal()) {
+        m_autosavedRevision = m_revision;
+        return true;
+    }
+    discardCompaction();
     
-    for (int i = 0; i < m_aisShapes.size(); ++i) {
-        if (!m_aisShapes[i].IsNull() && m_aisShapes[i] == aisShape) {
-            return i;
+    // 先写入临时文件，完成后再替换目标文件；未加载的形状直接从映射的源文件复制字节
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    const MycadWriter::Snapshot snapshot = takeSnapshot(false);
+    MycadWriter writer;
+    if (!writer.write(file, snapshot, m_sourceData)) {
+        file.cancelWriting();
+        return false;
+    }
+    const qint64 endPos = file.pos();
+    
+    // 替换文件前释放源文件映射（映射中的文件在Windows上不能被替换），完成后改为映射新文件
+    // 后台自动保存可能仍在读取源文件，先等它结束
+    waitForAutosave();
+    const QString sourceName = m_source ? m_source->fileName() : QString();
+    const int nbPending = pendingCount();
+    releaseSource();
+    const bool ok = file.commit();
+    if (nbPending > 0) {
+        if (ok && openSource(filename)) {
+            // 未加载的形状改为引用新文件中的数据块，已恢复的基础形状按新位置继续缓存
+            QHash<qint64, TopoDS_Shape> bases;
+            for (size_t k = 0; k < snapshot.items.size(); ++k) {
+                StoredBlock& stored = m_blocks[snapshot.items[k].index];
+                if (stored.offset < 0) {
+                    continue;
+                }
+                const MycadFile::Entry& entry = writer.entries()[k];
+                const TopoDS_Shape& base = writer.bases()[size_t(entry.block)];
+                stored.offset = entry.offset;
+                stored.size = entry.size;
+                stored.meshed = (entry.flags & MycadFile::FLAG_MESHED) != 0;
+                stored.location = entry.location;
+                stored.orientation = entry.orientation;
+                if (!base.IsNull()) {
+                    bases.insert(entry.offset, base);
+                }
+            }
+            m_loadedBases = bases;
+        } else if (!ok) {
+            openSource(sourceName);
+        }
+    }
+    
+    // 之后的保存追加到这个文件
+    if (ok) {
+        m_fileName = filename;
+        m_journalStart = endPos;
+        m_journalEnd = endPos;
+        m_removedRecords.clear();
+        for (StoredBlock& stored : m_blocks) {
+            stored.dirty = false;
         }
+        m_autosavedRevision = m_revision;
     }
     
-    return -1;
+    qDebug() << "Document::saveToFile() -" << filename << "形状:" << snapshot.items.size()
+             << "数据块:" << writer.blocks().size() << "未加载:" << nbPending << "线程:" << writer.threadCount()
+             << "大小(字节):" << endPos << "耗时(ms):" << timer.elapsed();
+    return ok;
 }
 
-bool Document::saveToFile(const QString& filename)
+bool Document::appendJournal()
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (m_journalEnd <= 0) {
         return false;
     }
     
-    QDataStream out(&file);
+    // 只有修改过的形状和删除记录需要写出
+    MycadWriter::Snapshot snapshot = takeSnapshot(true);
+    if (snapshot.items.empty() && m_removedRecords.isEmpty()) {
+        return true;
+    }
     
-    // 写入版本号
-    out << quint32(1);
+    // 文件头中的日志区间与上次保存时一致，说明文件没有被其他程序修改
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    QDataStream out(&file);
+    quint32 version = 0;
+    quint64 journalStart = 0;
+    quint64 journalEnd = 0;
+    quint32 count = 0;
+    out >> version >> journalStart >> journalEnd >> count >> snapshot.deviationCoefficient >> snapshot.deviationAngle;
+    if (out.status() != QDataStream::Ok || version != MycadFile::FORMAT_JOURNAL
+        || qint64(journalStart) != m_journalStart || qint64(journalEnd) != m_journalEnd
+        || file.size() < m_journalEnd) {
+        qDebug() << "Document::appendJournal() - 文件已变化，改为完整保存:" << m_fileName;
+        return false;
+    }
     
-    // 写入形状数量
-    out << quint32(m_shapes.size());
+    QElapsedTimer timer;
+    timer.start();
     
-    // 写入每个形状
-    for (int i = 0; i < m_shapes.size(); ++i) {
-        // 写入名称
-        out << m_shapeNames[i];
-        
-        // 将形状保存为BREP格式（二进制）
-        std::ostringstream oss;
-        BRepTools::Write(m_shapes[i], oss);
-        QString brepData = QString::fromStdString(oss.str());
-        out << brepData;
+    // 从上次提交的末尾开始写，之前未提交的内容被覆盖；三角网格按文件头中的精度检查
+    file.seek(m_journalEnd);
+    MycadWriter writer;
+    if (!writer.appendRecords(file, snapshot)) {
+        return false;
+    }
+    for (quint32 record : m_removedRecords) {
+        MycadFile::writeRemoveRecord(out, record);
     }
     
+    // 记录全部写入后才更新文件头中的日志末尾，中途失败时文件内容仍为上次提交的状态
+    const qint64 end = file.pos();
+    if (out.status() != QDataStream::Ok || !file.flush() || !MycadFile::commitJournal(file, end) || !file.flush()) {
+        qWarning() << "Document::appendJournal() - 写入日志失败:" << m_fileName << file.errorString();
+        return false;
+    }
     file.close();
+    
+    for (const MycadWriter::Item& item : snapshot.items) {
+        m_blocks[item.index].dirty = false;
+    }
+    const int nbRemoved = m_removedRecords.size();
+    m_removedRecords.clear();
+    m_journalEnd = end;
+    
+    qDebug() << "Document::appendJournal() -" << m_fileName << "修改:" << snapshot.items.size() << "删除:" << nbRemoved
+             << "数据块:" << writer.blocks().size() << "日志(字节):" << (m_journalEnd - m_journalStart)
+             << "耗时(ms):" << timer.elapsed();
+    
+    const qint64 journalSize = m_journalEnd - m_journalStart;
+    if (journalSize > THE_COMPACT_MIN_JOURNAL && journalSize * 4 > m_journalStart) {
+        startCompaction();
+    }
+    return true;
+}
+
+MycadWriter::Snapshot Document::takeSnapshot(bool changedOnly)
+{
+    // 只复制形状句柄和目录信息，几何与文档共享
+    MycadWriter::Snapshot snapshot;
+    const Handle(Prs3d_Drawer) viewer = viewerDrawer();
+    snapshot.deviationCoefficient = viewer->DeviationCoefficient();
+    snapshot.deviationAngle = viewer->DeviationAngle();
+    snapshot.loadedBases = m_loadedBases;
+    snapshot.sourceName = m_source ? m_source->fileName() : QString();
+    snapshot.items.reserve(size_t(m_shapes.size()));
+    for (int i = 0; i < m_shapes.size(); ++i) {
+        StoredBlock& stored = m_blocks[i];
+        if (changedOnly && !stored.dirty) {
+            continue;
+        }
+        if (stored.record == 0) {
+            stored.record = m_nextRecord++;
+        }
+        MycadWriter::Item item;
+        item.index = i;
+        item.stored.record = stored.record;
+        item.stored.name = m_shapeNames.at(i);
+        if (stored.offset < 0) {
+            item.shape = m_shapes.at(i);
+        } else {
+            item.stored.offset = stored.offset;
+            item.stored.size = stored.size;
+            item.stored.flags = stored.meshed ? MycadFile::FLAG_MESHED : 0;
+            item.stored.box = stored.box;
+            item.stored.location = stored.location;
+            item.stored.orientation = stored.orientation;
+        }
+        snapshot.items.push_back(item);
+    }
+    return snapshot;
+}
+
+bool Document::startAutosave(const QString& filename)
+{
+    if (m_autosaveTask || m_revision == m_autosavedRevision) {
+        return false;
+    }
+    m_autosaveTask = new AutosaveTask(filename, takeSnapshot(false), m_revision, this);
+    connect(m_autosaveTask, &QThread::finished, this, &Document::onAutosaveFinished);
+    m_autosaveTask->start(QThread::LowPriority);
     return true;
 }
 
+void Document::waitForAutosave()
+{
+    if (m_autosaveTask) {
+        m_autosaveTask->wait();
+    }
+}
+
+void Document::onAutosaveFinished()
+{
+    AutosaveTask* task = m_autosaveTask;
+    m_autosaveTask = nullptr;
+    if (task == nullptr) {
+        return;
+    }
+    task->deleteLater();
+    // 自动保存期间的修改留到下一次
+    if (task->succeeded() && task->revision() > m_autosavedRevision) {
+        m_autosavedRevision = task->revision();
+    }
+    emit autosaveFinished(task->fileName(), task->succeeded());
+}
+
+void Document::startCompaction()
+{
+    if (m_compactTask) {
+        return;
+    }
+    m_compactTask = new MycadCompactTask(m_fileName, m_journalEnd, this);
+    connect(m_compactTask, &QThread::finished, this, &Document::onCompactFinished);
+    m_compactTask->start(QThread::LowPriority);
+}
+
+void Document::discardCompaction()
+{
+    if (!m_compactTask) {
+        return;
+    }
+    disconnect(m_compactTask, nullptr, this, nullptr);
+    m_compactTask->wait();
+    QFile::remove(m_compactTask->targetName());
+    m_compactTask->deleteLater();
+    m_compactTask = nullptr;
+}
+
+void Document::onCompactFinished()
+{
+    MycadCompactTask* task = m_compactTask;
+    m_compactTask = nullptr;
+    if (task == nullptr) {
+        return;
+    }
+    task->deleteLater();
+    if (!task->succeeded()) {
+        return;
+    }
+    
+    // 整理期间又追加了日志或改存为其他文件：整理结果已过时
+    const QHash<qint64, qint64>& offsets = task->offsets();
+    bool current = task->fileName() == m_fileName && task->journalEnd() == m_journalEnd;
+    for (int i = 0; i < m_blocks.size() && current; ++i) {
+        current = m_blocks[i].offset < 0 || offsets.contains(m_blocks[i].offset);
+    }
+    if (!current) {
+        QFile::remove(task->targetName());
+        return;
+    }
+    
+    // 替换前释放源文件映射并等待读取源文件的自动保存，先把原文件改名备份，新文件到位后再删除备份
+    waitForAutosave();
+    const int nbPending = pendingCount();
+    releaseSource();
+    const QString backup = m_fileName + ".bak";
+    QFile::remove(backup);
+    bool ok = QFile::rename(m_fileName, backup);
+    if (ok && !QFile::rename(task->targetName(), m_fileName)) {
+        QFile::rename(backup, m_fileName);
+        ok = false;
+    }
+    if (ok) {
+        QFile::remove(backup);
+        m_journalStart = task->fileSize();
+        m_journalEnd = task->fileSize();
+        
+        // 未加载的形状和缓存的基础形状改为新文件中的位置
+        for (StoredBlock& stored : m_blocks) {
+            if (stored.offset >= 0) {
+                stored.offset = offsets.value(stored.offset);
+            }
+        }
+        QHash<qint64, TopoDS_Shape> bases;
+        for (auto it = m_loadedBases.constBegin(); it != m_loadedBases.constEnd(); ++it) {
+            bases.insert(offsets.value(it.key()), it.value());
+        }
+        m_loadedBases = bases;
+    } else {
+        qWarning() << "Document::onCompactFinished() - 无法替换文件:" << m_fileName;
+        QFile::remove(task->targetName());
+    }
+    if (nbPending > 0) {
+        openSource(m_fileName);
+    }
+    qDebug() << "Document::onCompactFinished() -" << m_fileName << (ok ? "整理完成，大小(字节):" : "整理失败")
+             << m_journalEnd;
+}
+
 bool Document::loadFromFile(const QString& filename)
 {
     QFile file(filename);
@@ -220,43 +843,173 @@ bool Document::loadFromFile(const QString& filename)
         return false;
     }
     
+    QElapsedTimer timer;
+    timer.start();
     QDataStream in(&file);
     
     // 读取版本号
     quint32 version;
     in >> version;
     
-    if (version != 1) {
-        file.close();
+    if (version < MycadFile::FORMAT_TEXT || version > MycadFile::FORMAT_JOURNAL) {
+        qWarning() << "Document::loadFromFile() - 不支持的文件版本:" << version << filename;
         return false;
     }
     
-    clear();
+    if (version >= MycadFile::FORMAT_INDEXED) {
+        // 只读取目录并回放日志，各形状先以包围盒占位，几何在第一次需要时才从映射中恢复
+        MycadFile::Index index;
+        if (!MycadFile::readIndex(file, index)) {
+            qWarning() << "Document::loadFromFile() - 文件已损坏:" << filename;
+            return false;
+        }
+        file.close();
+        
+        // 保存时的剖分精度与当前显示设置一致时，直接使用文件中的三角网格
+        bool sameDeflection = false;
+        if (version >= MycadFile::FORMAT_MESHED) {
+            const Handle(Prs3d_Drawer) viewer = viewerDrawer();
+            sameDeflection = std::abs(index.deviationCoefficient - viewer->DeviationCoefficient()) <= 1.0e-12
+                          && std::abs(index.deviationAngle - viewer->DeviationAngle()) <= 1.0e-12;
+        }
+        
+        QStringList names;
+        QList<StoredBlock> stored;
+        for (const MycadFile::Entry& entry : index.entries) {
+            StoredBlock block;
+            block.offset = entry.offset;
+            block.size = entry.size;
+            block.box = entry.box;
+            block.meshed = sameDeflection && (entry.flags & MycadFile::FLAG_MESHED) != 0;
+            block.location = entry.location;
+            block.orientation = entry.orientation;
+            block.record = entry.record;
+            block.dirty = false;
+            names.append(entry.name);
+            stored.append(block);
+        }
+        
+        // 清空、添加占位和立即加载合并为一次刷新和一次 documentChanged
+        beginUpdate();
+        clear();
+        if (!openSource(filename)) {
+            endUpdate();
+            return false;
+        }
+        // 版本6文件之后的保存直接追加日志，更早的版本在第一次保存时整体重写
+        m_fileName = filename;
+        if (version == MycadFile::FORMAT_JOURNAL) {
+            m_journalStart = index.journalStart;
+            m_journalEnd = index.journalEnd;
+        }
+        m_nextRecord = index.nextRecord;
+        
+        // 没有包围盒的形状无法占位，立即加载
+        QList<TopoDS_Shape> placeholders;
+        QList<int> immediate;
+        for (int i = 0; i < stored.size(); ++i) {
+            placeholders.append(placeholderShape(stored[i].box));
+            if (stored[i].box.IsVoid()) {
+                immediate.append(i);
+            }
+        }
+        appendShapes(placeholders, names, stored);
+        loadShapes(immediate);
+        m_autosavedRevision = m_revision;
+        endUpdate();
+        
+        qDebug() << "Document::loadFromFile() -" << filename << "版本:" << version << "形状:" << m_shapes.size()
+                 << "日志记录:" << index.nbJournalRecords << "未加载:" << pendingCount()
+                 << "耗时(ms):" << timer.elapsed();
+        if (m_view3D) {
+            m_view3D->fitAll();
+        }
+        return true;
+    }
     
-    // 读取形状数量
+    // 版本1、2：顺序读取名称和各形状数据的位置，版本2的数据块直接引用文件映射
     quint32 count;
     in >> count;
-    
-    // 读取每个形状
-    for (quint32 i = 0; i < count; ++i) {
-        QString name;
-        in >> name;
-        
-        QString brepData;
-        in >> brepData;
-        
-        // 从BREP数据恢复形状
-        std::istringstream iss(brepData.toStdString());
-        TopoDS_Shape shape;
-        BRep_Builder builder;
-        BRepTools::Read(shape, iss, builder);
-        if (!shape.IsNull()) {
-            addShape(shape, name);
+    const uchar* mapped = version == MycadFile::FORMAT_BINARY ? file.map(0, file.size()) : nullptr;
+    std::vector<ShapeBlock> blocks;
+    blocks.reserve(std::min<quint32>(count, 1 << 20));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ShapeBlock block;
+        in >> block.name;
+        if (version == MycadFile::FORMAT_TEXT) {
+            // 旧版本：文本BREP保存为QString
+            QString brepData;
+            in >> brepData;
+            block.storage = brepData.toUtf8();
+        } else {
+            quint64 size = 0;
+            in >> size;
+            const qint64 blockStart = file.pos();
+            if (in.status() != QDataStream::Ok || qint64(size) > file.size() - blockStart) {
+                qWarning() << "Document::loadFromFile() - 文件已损坏:" << filename;
+                break;
+            }
+            if (mapped != nullptr) {
+                block.data = reinterpret_cast<const char*>(mapped) + blockStart;
+                file.seek(blockStart + qint64(size));
+            } else {
+                block.storage = file.read(qint64(size));
+            }
+            block.size = qint64(size);
+        }
+        if (block.data == nullptr) {
+            block.data = block.storage.constData();
+            block.size = block.storage.size();
         }
+        blocks.push_back(std::move(block));
     }
+    const qint64 scanMs = timer.restart();
     
+    // 各形状的数据相互独立，由工作线程并行恢复
+    const int nbBlocks = int(blocks.size());
+    OSD_Parallel::For(0, nbBlocks, [&blocks, version](int i) {
+        ShapeBlock& block = blocks[size_t(i)];
+        try {
+            MemoryBuf buffer(block.data, block.size);
+            std::istream stream(&buffer);
+            if (version == MycadFile::FORMAT_TEXT) {
+                BRep_Builder builder;
+                BRepTools::Read(block.shape, stream, builder);
+            } else {
+                BinTools::Read(block.shape, stream);
+            }
+        } catch (const Standard_Failure& e) {
+            qWarning() << "Document::loadFromFile() - OpenCascade异常:" << block.name << e.GetMessageString();
+            block.shape.Nullify();
+        }
+        QByteArray().swap(block.storage);
+    }, nbBlocks <= 1);
+    const qint64 readMs = timer.restart();
+    
+    if (mapped != nullptr) {
+        file.unmap(const_cast<uchar*>(mapped));
+    }
     file.close();
     
+    // 显示只在GUI线程进行：整批添加，只刷新一次视图
+    beginUpdate();
+    clear();
+    QList<TopoDS_Shape> shapes;
+    QStringList names;
+    for (const ShapeBlock& block : blocks) {
+        if (!block.shape.IsNull()) {
+            shapes.append(block.shape);
+            names.append(block.name);
+        }
+    }
+    addShapes(shapes, names);
+    m_fileName = filename;
+    m_autosavedRevision = m_revision;
+    endUpdate();
+    
+    qDebug() << "Document::loadFromFile() -" << filename << "版本:" << version << "形状:" << m_shapes.size()
+             << "扫描(ms):" << scanMs << "恢复(ms):" << readMs << "显示(ms):" << timer.elapsed();
+    
     if (m_view3D) {
         m_view3D->fitAll();
     }
@@ -264,6 +1017,143 @@ bool Document::loadFromFile(const QString& filename)
     return true;
 }
 
+void Document::loadShapes(const QList<int>& indices)
+{
+    std::vector<int> pending;
+    for (int index : indices) {
+        if (index >= 0 && index < m_blocks.size() && m_blocks[index].offset >= 0
+            && std::find(pending.begin(), pending.end(), index) == pending.end()) {
+            pending.push_back(index);
+        }
+    }
+    if (pending.empty() || m_sourceData == nullptr) {
+        return;
+    }
+    
+    // 按数据块归并：同一块只恢复一次，引用它的形状共享同一个 TShape
+    QElapsedTimer timer;
+    timer.start();
+    QHash<qint64, int> slots;
+    std::vector<const StoredBlock*> ranges;
+    for (int index : pending) {
+        const StoredBlock& block = m_blocks[index];
+        if (!m_loadedBases.contains(block.offset) && !slots.contains(block.offset)) {
+            slots.insert(block.offset, int(ranges.size()));
+            ranges.push_back(&block);
+        }
+    }
+    
+    const int nbRanges = int(ranges.size());
+    const char* data = reinterpret_cast<const char*>(m_sourceData);
+    std::vector<TopoDS_Shape> bases(ranges.size());
+    OSD_Parallel::For(0, nbRanges, [&](int k) {
+        const StoredBlock& block = *ranges[size_t(k)];
+        try {
+            MemoryBuf buffer(data + block.offset, block.size);
+            std::istream stream(&buffer);
+            BinTools::Read(bases[size_t(k)], stream);
+        } catch (const Standard_Failure& e) {
+            qWarning() << "Document::loadShapes() - OpenCascade异常:" << e.GetMessageString();
+            bases[size_t(k)].Nullify();
+        }
+    }, nbRanges <= 1);
+    
+    // 恢复失败的形状保留占位，保存时仍按原始字节写出
+    int nbLoaded = 0;
+    for (int index : pending) {
+        const StoredBlock block = m_blocks[index];
+        const TopoDS_Shape base = slots.contains(block.offset) ? bases[size_t(slots.value(block.offset))]
+                                                               : m_loadedBases.value(block.offset);
+        if (base.IsNull()) {
+            qWarning() << "Document::loadShapes() - 无法恢复形状:" << m_shapeNames[index];
+            continue;
+        }
+        const TopoDS_Shape shape = MycadWriter::placeInstance(base, block.location, block.orientation);
+        StoredBlock loaded;
+        loaded.record = block.record;
+        loaded.dirty = block.dirty;
+        m_shapes[index] = shape;
+        m_blocks[index] = loaded;
+        swapDisplayObject(index, createDisplayObject(shape, block.meshed));
+        ++nbLoaded;
+    }
+    
+    // 仍被未加载形状引用的基础形状保留在缓存中，之后加载的实例继续共享
+    QHash<qint64, TopoDS_Shape> cache;
+    for (const StoredBlock& block : m_blocks) {
+        if (block.offset < 0 || cache.contains(block.offset)) {
+            continue;
+        }
+        if (m_loadedBases.contains(block.offset)) {
+            cache.insert(block.offset, m_loadedBases.value(block.offset));
+        } else if (slots.contains(block.offset) && !bases[size_t(slots.value(block.offset))].IsNull()) {
+            cache.insert(block.offset, bases[size_t(slots.value(block.offset))]);
+        }
+    }
+    m_loadedBases = cache;
+    
+    if (nbLoaded == 0) {
+        return;
+    }
+    
+    // 全部加载后不再需要源文件
+    const int nbRemaining = pendingCount();
+    if (nbRemaining == 0) {
+        releaseSource();
+    }
+    qDebug() << "Document::loadShapes() - 加载:" << nbLoaded << "数据块:" << nbRanges << "剩余:" << nbRemaining
+             << "耗时(ms):" << timer.elapsed();
+    notifyChanged();
+}
+
+bool Document::isLoaded(int index) const
+{
+    return index >= 0 && index < m_blocks.size() && m_blocks[index].offset < 0;
+}
+
+int Document::pendingCount() const
+{
+    int count = 0;
+    for (const StoredBlock& block : m_blocks) {
+        if (block.offset >= 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool Document::openSource(const QString& filename)
+{
+    releaseSource();
+    std::unique_ptr<QFile> file(new QFile(filename));
+    if (!file->open(QIODevice::ReadOnly)) {
+        qWarning() << "Document::openSource() - 无法打开文件，未加载的形状不可用:" << filename << file->errorString();
+        return false;
+    }
+    m_sourceData = file->map(0, file->size());
+    if (m_sourceData == nullptr) {
+        // 无法映射时整体读入内存
+        m_sourceBuffer = file->readAll();
+        m_sourceData = reinterpret_cast<const uchar*>(m_sourceBuffer.constData());
+    }
+    m_source = std::move(file);
+    return true;
+}
+
+void Document::releaseSource()
+{
+    if (!m_source) {
+        return;
+    }
+    if (m_sourceData != nullptr && m_sourceBuffer.isEmpty()) {
+        m_source->unmap(const_cast<uchar*>(m_sourceData));
+    }
+    m_sourceData = nullptr;
+    QByteArray().swap(m_sourceBuffer);
+    m_source->close();
+    m_source.reset();
+}
+
 QStringList Document::getShapeNames() const
 {
     return m_shapeNames;
@@ -275,3 +1165,46 @@ QString Document::generateName(const QString& prefix)
     return name;
 }
 
+Handle(AIS_InteractiveObject) Document::createDisplayObject(const TopoDS_Shape& shape, bool meshed) const
+{
+    TopLoc_Location location;
+    Handle(Poly_Triangulation) triangulation = meshOnlyTriangulation(shape, location);
+    if (!triangulation.IsNull()) {
+        // 网格对象：用 MeshVS 直接显示三角网格，避免逐三角形的面和选择实体
+        Handle(MeshVS_Mesh) mesh = new MeshVS_Mesh();
+        mesh->SetDataSource(new TriangulationDataSource(triangulation));
+        mesh->AddBuilder(new MeshVS_MeshPrsBuilder(mesh), Standard_True);
+        mesh->GetDrawer()->SetBoolean(MeshVS_DA_DisplayNodes, Standard_False);
+        mesh->GetDrawer()->SetBoolean(MeshVS_DA_ShowEdges, Standard_False);
+        mesh->SetDisplayMode(MeshVS_DMF_Shading);
+        if (!location.IsIdentity()) {
+            mesh->SetLocalTransformation(location.Transformation());
+        }
+        qDebug() << "Document::createDisplayObject() - 网格对象，三角形:" << triangulation->NbTriangles();
+        return mesh;
+    }
+    
+    Handle(AIS_Shape) aisShape = new AIS_Shape(shape);
+    // 使用 Shaded 模式
+    aisShape->SetDisplayMode(AIS_Shaded);
+    // 启用面的边界线显示，实现着色带边效果
+    Handle(Prs3d_Drawer) drawer = aisShape->Attributes();
+    if (!drawer.IsNull()) {
+        drawer->SetFaceBoundaryDraw(Standard_True);
+        if (meshed) {
+            // 文件中的三角网格按当前精度剖分，显示时不再调用 BRepMesh
+            drawer->SetAutoTriangulation(Standard_False);
+        }
+    }
+    return aisShape;
+}
+
+
+Handle(Prs3d_Drawer) Document::viewerDrawer() const
+{
+    // 显示对象的剖分精度继承自上下文的默认属性
+    if (m_view3D && !m_view3D->getContext().IsNull()) {
+        return m_view3D->getContext()->DefaultDrawer();
+    }
+    return new Prs3d_Drawer();
+}
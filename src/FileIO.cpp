@@ -1,52 +1,300 @@
 ﻿#include "FileIO.h"
+#include "ObjReader.h"
+#include "StlReader.h"
+#include "IgesReader.h"
+#include "StepParser.h"
+#include "DecompressDevice.h"
+#include "TranslationCache.h"
+#include "GltfReader.h"
+#include "GltfWriter.h"
+#include "ObjWriter.h"
+#include "StlWriter.h"
+#include "SharedGraphSession.h"
+#include <STEPControl_Controller.hxx>
+#include <IGESControl_Controller.hxx>
 #include <STEPControl_Reader.hxx>
 #include <STEPControl_Writer.hxx>
-#include <IGESControl_Reader.hxx>
 #include <IGESControl_Writer.hxx>
 #include <StlAPI_Reader.hxx>
-#include <StlAPI_Writer.hxx>
+#include <XSControl_WorkSession.hxx>
+#include <Interface_InterfaceModel.hxx>
+#include <StepBasic_ProductDefinition.hxx>
+#include <StepRepr_NextAssemblyUsageOccurrence.hxx>
+#include <OSD_Parallel.hxx>
+#include <Message_ProgressScope.hxx>
+#include <BRep_Builder.hxx>
+#include <Interface_Static.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Face.hxx>
 #include <QFileInfo>
+#include <QElapsedTimer>
+#include <QThread>
 #include <QDebug>
+#include <Standard_Failure.hxx>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <istream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-bool FileIO::importFile(const QString& filename, TopoDS_Shape& shape)
+namespace {
+
+// Interface_Static 的整数参数是进程级设置：临时修改后在作用域结束时恢复，转换抛出异常时也不例外
+class StaticIntGuard
+{
+public:
+    explicit StaticIntGuard(const char* name)
+        : m_name(name)
+        , m_saved(Interface_Static::IVal(name))
+    {
+    }
+    ~StaticIntGuard() { Interface_Static::SetIVal(m_name, m_saved); }
+    
+    void set(int value) { Interface_Static::SetIVal(m_name, value); }
+    
+    StaticIntGuard(const StaticIntGuard&) = delete;
+    StaticIntGuard& operator=(const StaticIntGuard&) = delete;
+    
+private:
+    const char* m_name;
+    int m_saved;
+};
+
+// 根对象是否通过装配关系（NAUO）引用同一个产品定义；共享的子装配必须在同一个
+// TransientProcess 中转换，否则各线程分别转换出互不共享的重复 TShape
+bool rootsShareProducts(STEPControl_Reader& reader, Standard_Integer nbRoots)
+{
+    Handle(Interface_InterfaceModel) model = reader.Model();
+    std::unordered_map<const Standard_Transient*, std::vector<const Standard_Transient*>> children;
+    const Standard_Integer nbEntities = model->NbEntities();
+    for (Standard_Integer i = 1; i <= nbEntities; ++i) {
+        Handle(StepRepr_NextAssemblyUsageOccurrence) usage =
+            Handle(StepRepr_NextAssemblyUsageOccurrence)::DownCast(model->Value(i));
+        if (!usage.IsNull() && !usage->RelatingProductDefinition().IsNull()
+            && !usage->RelatedProductDefinition().IsNull()) {
+            children[usage->RelatingProductDefinition().get()].push_back(usage->RelatedProductDefinition().get());
+        }
+    }
+    if (children.empty()) {
+        return false;
+    }
+    
+    // 从每个根对象展开装配树，记录产品定义所属的根
+    std::unordered_map<const Standard_Transient*, Standard_Integer> ownerRoot;
+    for (Standard_Integer root = 1; root <= nbRoots; ++root) {
+        Handle(StepBasic_ProductDefinition) definition =
+            Handle(StepBasic_ProductDefinition)::DownCast(reader.RootForTransfer(root));
+        if (definition.IsNull()) {
+            continue;
+        }
+        std::vector<const Standard_Transient*> pending(1, definition.get());
+        while (!pending.empty()) {
+            const Standard_Transient* current = pending.back();
+            pending.pop_back();
+            auto inserted = ownerRoot.emplace(current, root);
+            if (!inserted.second) {
+                if (inserted.first->second != root) {
+                    return true;
+                }
+                continue;
+            }
+            auto it = children.find(current);
+            if (it != children.end()) {
+                pending.insert(pending.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool FileIO::importFile(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options,
+                        const Message_ProgressRange& progress)
 {
     QFileInfo fileInfo(filename);
     QString suffix = fileInfo.suffix().toLower();
     
+    // 压缩文件（.gz / .zst）：按解压后的内容识别格式，读取器直接从解压流读取，不落盘临时文件；
+    // IGES读取器只接受文件路径，无法从解压流读取
+    if (DecompressDevice::detect(filename) != Compression::None) {
+        suffix = DecompressDevice::payloadFormat(filename);
+        if (suffix == "iges") {
+            qWarning() << "FileIO::importFile() - 不支持压缩的IGES文件，请先解压:" << filename;
+            return false;
+        }
+        if (suffix != "step" && suffix != "stl" && suffix != "obj") {
+            qWarning() << "FileIO::importFile() - 不支持的压缩文件内容格式:" << filename << suffix;
+            return false;
+        }
+    }
+    
+    // STEP/IGES 转换耗时，先按文件内容查找缓存
+    const bool cacheable = options.useCache && TranslationCache::instance().isEnabled()
+                        && (suffix == "step" || suffix == "stp" || suffix == "iges" || suffix == "igs");
+    QByteArray cacheKey;
+    if (cacheable) {
+        cacheKey = TranslationCache::instance().key(filename, options);
+        if (TranslationCache::instance().lookup(cacheKey, shape)) {
+            deliverPart(options, filename, shape, true);
+            return true;
+        }
+    }
+    
+    // STEP/IGES 在转换过程中报告进度；网格格式读取较快，只在完成后检查取消
+    Message_ProgressScope scope(progress, fileInfo.fileName().toStdString().c_str(), 1);
+    bool result = false;
     if (suffix == "step" || suffix == "stp") {
-        return importSTEP(filename, shape);
+        result = importSTEP(filename, shape, options, scope.Next());
     } else if (suffix == "iges" || suffix == "igs") {
-        return importIGES(filename, shape);
+        result = importIGES(filename, shape, options, scope.Next());
     } else if (suffix == "stl") {
-        return importSTL(filename, shape);
+        result = importSTL(filename, shape, options);
     } else if (suffix == "obj") {
-        return importOBJ(filename, shape);
+        result = importOBJ(filename, shape, options);
     } else if (suffix == "gltf") {
-        return importGLTF(filename, shape);
+        result = importGLTF(filename, shape, options);
     } else if (suffix == "glb") {
-        return importGLB(filename, shape);
+        result = importGLB(filename, shape, options);
     }
     
-    return false;
+    if (scope.UserBreak()) {
+        qDebug() << "FileIO::importFile() - 已取消:" << filename;
+        shape.Nullify();
+        return false;
+    }
+    if (result && cacheable) {
+        TranslationCache::instance().store(cacheKey, shape);
+    }
+    // STEP/IGES 在转换过程中逐个交出部件，其他格式读完后整体交出
+    const bool streamed = suffix == "step" || suffix == "stp" || suffix == "iges" || suffix == "igs";
+    if (result && !streamed) {
+        deliverPart(options, filename, shape, false);
+    }
+    return result;
+}
+
+void FileIO::deliverPart(const ImportOptions& options, const QString& filename, const TopoDS_Shape& part, bool mesh)
+{
+    if (!options.partCallback || part.IsNull()) {
+        return;
+    }
+    if (mesh) {
+        // 与 AIS_Shape 默认的相对偏差一致，显示时直接复用已有的三角网格
+        Handle(Prs3d_Drawer) drawer = new Prs3d_Drawer();
+        try {
+            StdPrs_ToolTriangulatedShape::Tessellate(part, drawer);
+        } catch (const Standard_Failure& e) {
+            qWarning() << "FileIO::deliverPart() - 剖分异常:" << filename << e.GetMessageString();
+        }
+    }
+    options.partCallback(filename, part);
 }
 
-bool FileIO::exportFile(const QString& filename, const TopoDS_Shape& shape)
+QList<ImportResult> FileIO::importFiles(const QStringList& filenames, const ImportOptions& options, int maxWorkers,
+                                        const Message_ProgressRange& progress)
+{
+    const int nbFiles = filenames.size();
+    std::vector<ImportResult> results(nbFiles);
+    if (nbFiles == 0) {
+        return QList<ImportResult>();
+    }
+    
+    // 转换器的全局静态数据在主线程初始化一次，避免工作线程并发初始化
+    STEPControl_Controller::Init();
+    IGESControl_Controller::Init();
+    
+    const int nbCores = resolveThreadCount(options.threadCount);
+    const int nbWorkers = std::max(1, std::min(nbFiles, maxWorkers > 0 ? maxWorkers : nbCores));
+    ImportOptions workerOptions = options;
+    workerOptions.threadCount = std::max(1, nbCores / nbWorkers);
+    
+    QElapsedTimer total;
+    total.start();
+    
+    // 进度区间在启动工作线程前按文件预先分配，各线程只使用自己的区间
+    Message_ProgressScope scope(progress, "导入", nbFiles);
+    std::vector<Message_ProgressRange> ranges;
+    ranges.reserve(nbFiles);
+    for (int i = 0; i < nbFiles; ++i) {
+        ranges.push_back(scope.Next());
+    }
+    
+    // 每个工作线程依次领取下一个文件，每次转换使用独立的读取器实例
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < nbFiles; i = next++) {
+            ImportResult& result = results[i];
+            result.filename = filenames[i];
+            if (ranges[i].UserBreak()) {
+                continue;
+            }
+            QElapsedTimer timer;
+            timer.start();
+            try {
+                result.success = importFile(result.filename, result.shape, workerOptions, ranges[i])
+                              && !result.shape.IsNull();
+            } catch (const Standard_Failure& e) {
+                qWarning() << "FileIO::importFiles() - OpenCascade异常:" << result.filename << e.GetMessageString();
+            } catch (const std::exception& e) {
+                qWarning() << "FileIO::importFiles() - 标准异常:" << result.filename << e.what();
+            } catch (...) {
+                qWarning() << "FileIO::importFiles() - 未知异常:" << result.filename;
+            }
+            result.elapsedMs = timer.elapsed();
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nbWorkers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    int nbFailed = 0;
+    for (const ImportResult& result : results) {
+        if (!result.success) {
+            ++nbFailed;
+        }
+    }
+    qDebug() << "FileIO::importFiles() - 文件:" << nbFiles << "失败:" << nbFailed
+             << "工作线程:" << nbWorkers << "每线程核心:" << workerOptions.threadCount
+             << "总耗时(ms):" << total.elapsed();
+    
+    QList<ImportResult> list;
+    list.reserve(nbFiles);
+    for (ImportResult& result : results) {
+        list.append(result);
+    }
+    return list;
+}
+
+bool FileIO::exportFile(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options)
 {
     QFileInfo fileInfo(filename);
     QString suffix = fileInfo.suffix().toLower();
     
     if (suffix == "step" || suffix == "stp") {
-        return exportSTEP(filename, shape);
+        return exportSTEP(filename, shape, options);
     } else if (suffix == "iges" || suffix == "igs") {
         return exportIGES(filename, shape);
     } else if (suffix == "stl") {
-        return exportSTL(filename, shape);
+        return exportSTL(filename, shape, options);
     } else if (suffix == "obj") {
-        return exportOBJ(filename, shape);
+        return exportOBJ(filename, shape, options);
     } else if (suffix == "gltf") {
-        return exportGLTF(filename, shape);
+        return exportGLTF(filename, shape, options);
     } else if (suffix == "glb") {
-        return exportGLB(filename, shape);
+        return exportGLB(filename, shape, options);
     }
     
     return false;
@@ -59,7 +307,8 @@ QStringList FileIO::getImportFormats()
                         << "STL (*.stl)"
                         << "OBJ (*.obj)"
                         << "GLTF (*.gltf)"
-                        << "GLB (*.glb)";
+                        << "GLB (*.glb)"
+                        << "压缩的STEP/STL/OBJ (*.gz *.zst)";
 }
 
 QStringList FileIO::getExportFormats()
@@ -79,14 +328,80 @@ QString FileIO::getFileFilter(bool isImport)
     return allFormats + ";;所有文件 (*.*)";
 }
 
-bool FileIO::importSTEP(const QString& filename, TopoDS_Shape& shape)
+QStringList FileIO::getMeshPresetNames()
+{
+    // 顺序与 MeshPreset 一致
+    return QStringList() << "粗糙 (0.5, 30°)"
+                        << "标准 (0.1, 0.5 rad)"
+                        << "精细 (0.01, 0.2 rad)";
+}
+
+void FileIO::applyMeshPreset(ExportOptions& options, MeshPreset preset)
 {
+    switch (preset) {
+    case MeshPreset::Coarse:
+        options.linearDeflection = 0.5;
+        options.angularDeflection = 0.5236;
+        break;
+    case MeshPreset::Standard:
+        options.linearDeflection = 0.1;
+        options.angularDeflection = 0.5;
+        break;
+    case MeshPreset::Fine:
+        options.linearDeflection = 0.01;
+        options.angularDeflection = 0.2;
+        break;
+    }
+}
+
+bool FileIO::canImport(const QString& filename)
+{
+    static const QStringList suffixes = QStringList() << "step" << "stp" << "iges" << "igs"
+                                                      << "stl" << "obj" << "gltf" << "glb" << "gz" << "zst";
+    return suffixes.contains(QFileInfo(filename).suffix().toLower());
+}
+
+int FileIO::resolveThreadCount(int requested)
+{
+    if (requested > 0) {
+        return requested;
+    }
+    return std::max(1, QThread::idealThreadCount());
+}
+
+bool FileIO::importSTEP(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options,
+                        const Message_ProgressRange& progress)
+{
+    // 解析阶段不支持进度报告，按整体的十分之一计
+    Message_ProgressScope scope(progress, "STEP", 10);
     STEPControl_Reader reader;
-    IFSelect_ReturnStatus status = reader.ReadFile(filename.toStdString().c_str());
+    bool loaded = false;
+    const bool compressed = DecompressDevice::detect(filename) != Compression::None;
+    if (options.stepParallelParse && !compressed && QFileInfo(filename).size() >= options.stepParallelMinSize) {
+        StepParser parser(options.threadCount);
+        loaded = parser.read(filename, reader);
+        if (!loaded) {
+            qWarning() << "FileIO::importSTEP() - 并行解析失败，改用标准解析:" << filename;
+        }
+    }
+    if (!loaded && compressed) {
+        // 边解压边解析，解压数据不整体驻留内存
+        DecompressDevice device(filename);
+        if (!device.open(QIODevice::ReadOnly)) {
+            qWarning() << "FileIO::importSTEP() - 无法打开压缩文件:" << filename << device.errorString();
+            return false;
+        }
+        DeviceStreamBuf buffer(&device);
+        std::istream stream(&buffer);
+        loaded = reader.ReadStream(filename.toStdString().c_str(), stream) == IFSelect_RetDone;
+    } else if (!loaded) {
+        loaded = reader.ReadFile(filename.toStdString().c_str()) == IFSelect_RetDone;
+    }
     
-    if (status != IFSelect_RetDone) {
+    if (!loaded || !scope.More()) {
         return false;
     }
+    scope.Next();
     
     // 读取所有根对象
     Standard_Integer nbRoots = reader.NbRootsForTransfer();
@@ -94,74 +409,247 @@ bool FileIO::importSTEP(const QString& filename, TopoDS_Shape& shape)
         return false;
     }
     
-    // 转移第一个根对象
-    reader.TransferRoot(1);
-    Standard_Integer nbShapes = reader.NbShapes();
-    if (nbShapes == 0) {
+    if (!options.stepAllRoots) {
+        // 转移第一个根对象
+        reader.TransferRoot(1, scope.Next(9));
+        Standard_Integer nbShapes = reader.NbShapes();
+        if (nbShapes == 0) {
+            return false;
+        }
+        
+        shape = reader.Shape(1);
+        deliverPart(options, filename, shape, true);
+        return !shape.IsNull();
+    }
+    
+    // 多根模式：各工作线程拥有独立的会话和读取器，共享已解析的模型和主读取器建好的实体图，
+    // 按轮询方式分配根对象，避免在同一个 TransientProcess 上并发转换
+    // 根对象共享子装配时只用一个线程，共享的零件只转换一次，结果中仍是同一个 TShape
+    Handle(Interface_InterfaceModel) model = reader.Model();
+    Handle(Interface_HGraph) graph = reader.WS()->HGraph();
+    const bool shared = nbRoots > 1 && rootsShareProducts(reader, nbRoots);
+    const int nbWorkers = shared ? 1 : std::min(resolveThreadCount(options.threadCount), int(nbRoots));
+    if (shared) {
+        qDebug() << "FileIO::importSTEP() - 根对象共享子装配，按单线程转换:" << filename;
+    }
+    
+    struct RootResult
+    {
+        TopoDS_Shape shape;
+        qint64 elapsedMs = 0;
+    };
+    std::vector<RootResult> results(nbRoots);
+    
+    Message_ProgressScope transferScope(scope.Next(9), "转换根对象", nbRoots);
+    std::vector<Message_ProgressRange> ranges;
+    ranges.reserve(nbRoots);
+    for (Standard_Integer root = 1; root <= nbRoots; ++root) {
+        ranges.push_back(transferScope.Next());
+    }
+    
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    
+    OSD_Parallel::For(0, nbWorkers, [&](int worker) {
+        Handle(SharedGraphSession) session = new SharedGraphSession();
+        STEPControl_Reader workerReader(session, Standard_False);
+        session->SetModel(model);
+        session->shareGraph(graph);
+        session->InitTransferReader(4);
+        
+        for (Standard_Integer root = worker + 1; root <= nbRoots; root += nbWorkers) {
+            if (ranges[root - 1].UserBreak()) {
+                break;
+            }
+            QElapsedTimer rootTimer;
+            rootTimer.start();
+            
+            Standard_Integer nbBefore = workerReader.NbShapes();
+            workerReader.TransferRoot(root, ranges[root - 1]);
+            if (workerReader.NbShapes() > nbBefore) {
+                results[root - 1].shape = workerReader.Shape(workerReader.NbShapes());
+            }
+            results[root - 1].elapsedMs = rootTimer.elapsed();
+            deliverPart(options, filename, results[root - 1].shape, true);
+        }
+    }, nbWorkers == 1);
+    
+    // 合并为一个复合体，保持根对象的原始顺序
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    int nbTransferred = 0;
+    for (const RootResult& result : results) {
+        if (!result.shape.IsNull()) {
+            builder.Add(compound, result.shape);
+            ++nbTransferred;
+        }
+    }
+    
+    // 输出每个根对象的转换耗时（按耗时从高到低）
+    qDebug() << "FileIO::importSTEP() - 根对象:" << nbRoots << "成功:" << nbTransferred
+             << "线程:" << nbWorkers << "总耗时(ms):" << totalTimer.elapsed();
+    std::vector<int> order(nbRoots);
+    for (int i = 0; i < nbRoots; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&results](int a, int b) {
+        return results[a].elapsedMs > results[b].elapsedMs;
+    });
+    for (int i : order) {
+        qDebug() << "FileIO::importSTEP() - 根对象" << (i + 1) << "耗时(ms):" << results[i].elapsedMs
+                 << (results[i].shape.IsNull() ? "(无结果)" : "");
+    }
+    
+    if (nbTransferred == 0) {
         return false;
     }
     
-    shape = reader.Shape(1);
+    // 只有一个结果时直接返回，避免多余的复合体层级
+    if (nbTransferred == 1) {
+        for (const RootResult& result : results) {
+            if (!result.shape.IsNull()) {
+                shape = result.shape;
+                break;
+            }
+        }
+    } else {
+        shape = compound;
+    }
     return !shape.IsNull();
 }
 
-bool FileIO::importIGES(const QString& filename, TopoDS_Shape& shape)
+bool FileIO::importIGES(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options,
+                        const Message_ProgressRange& progress)
 {
-    IGESControl_Reader reader;
-    IFSelect_ReturnStatus status = reader.ReadFile(filename.toStdString().c_str());
-    
-    if (status != IFSelect_RetDone) {
-        return false;
+    // 并行转换全部根实体，散面缝合为壳
+    IgesReader reader(options.threadCount);
+    reader.setSewingTolerance(options.igesSewingTolerance);
+    if (options.partCallback) {
+        reader.setPartCallback([&options, &filename](const TopoDS_Shape& part) {
+            deliverPart(options, filename, part, true);
+        });
     }
-    
-    reader.TransferRoots();
-    Standard_Integer nbShapes = reader.NbShapes();
-    if (nbShapes == 0) {
+    if (!reader.read(filename, progress)) {
         return false;
     }
     
-    shape = reader.Shape(1);
+    shape = reader.shape();
     return !shape.IsNull();
 }
 
-bool FileIO::importSTL(const QString& filename, TopoDS_Shape& shape)
+bool FileIO::importSTL(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options)
 {
+    // 压缩文件只能按网格模式从解压流分块读取
+    const bool compressed = DecompressDevice::detect(filename) != Compression::None;
+    if (options.stlMeshOnly || compressed) {
+        // 网格模式：内存映射 + 并行焊接，结果为只带三角网格的面，显示为网格对象
+        StlReader reader(options.threadCount);
+        if (compressed) {
+            DecompressDevice device(filename);
+            if (!device.open(QIODevice::ReadOnly)) {
+                qWarning() << "FileIO::importSTL() - 无法打开压缩文件:" << filename << device.errorString();
+                return false;
+            }
+            if (!reader.read(device, filename)) {
+                return false;
+            }
+        } else if (!reader.read(filename)) {
+            return false;
+        }
+        
+        TopoDS_Face face;
+        BRep_Builder builder;
+        builder.MakeFace(face, reader.triangulation());
+        shape = face;
+        return !shape.IsNull();
+    }
+    
+    // B-rep模式：每个三角形一个面，可参与建模运算，但大文件内存占用很高
     StlAPI_Reader reader;
     return reader.Read(shape, filename.toStdString().c_str()) == Standard_True;
 }
 
-bool FileIO::importOBJ(const QString& filename, TopoDS_Shape& shape)
+bool FileIO::importOBJ(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options)
 {
-    // OpenCascade不直接支持OBJ，需要第三方库或手动解析
-    // 这里返回false，可以后续扩展
-    qDebug() << "OBJ import not yet implemented";
-    return false;
+    // 原生OBJ读取：内存映射 + 并行分块解析，结果为只带三角网格的面
+    ObjReader reader(options.threadCount);
+    if (DecompressDevice::detect(filename) != Compression::None) {
+        DecompressDevice device(filename);
+        if (!device.open(QIODevice::ReadOnly)) {
+            qWarning() << "FileIO::importOBJ() - 无法打开压缩文件:" << filename << device.errorString();
+            return false;
+        }
+        if (!reader.read(device, filename)) {
+            return false;
+        }
+    } else if (!reader.read(filename)) {
+        return false;
+    }
+    
+    TopoDS_Face face;
+    BRep_Builder builder;
+    builder.MakeFace(face, reader.triangulation());
+    shape = face;
+    return !shape.IsNull();
 }
 
-bool FileIO::importGLTF(const QString& filename, TopoDS_Shape& shape)
+bool FileIO::importGLTF(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options)
 {
-    // OpenCascade不直接支持GLTF，需要第三方库
-    qDebug() << "GLTF import not yet implemented";
-    return false;
+    // 原生glTF读取：外部缓冲区只映射一次，重复引用的网格以实例共享
+    GltfReader reader(options.threadCount);
+    if (!reader.read(filename)) {
+        return false;
+    }
+    
+    shape = reader.shape();
+    return !shape.IsNull();
 }
 
-bool FileIO::importGLB(const QString& filename, TopoDS_Shape& shape)
+bool FileIO::importGLB(const QString& filename, TopoDS_Shape& shape, const ImportOptions& options)
 {
-    // GLB是GLTF的二进制格式
-    qDebug() << "GLB import not yet implemented";
-    return false;
+    // GLB是GLTF的二进制格式，由同一个读取器按文件头识别
+    return importGLTF(filename, shape, options);
 }
 
-bool FileIO::exportSTEP(const QString& filename, const TopoDS_Shape& shape)
+bool FileIO::exportSTEP(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options)
 {
+    QElapsedTimer timer;
+    timer.start();
+    
+    // 实例化模式：复合体按装配写出，转换器按去掉位置后的形状查找已转换的零件，
+    // 阵列等共享同一 TShape 的子形状只转换一次，各实例写成带位置的装配引用
+    int nbInstances = 0;
+    TopTools_MapOfShape parts;
+    if (options.stepInstancing && shape.ShapeType() == TopAbs_COMPOUND) {
+        for (TopoDS_Iterator it(shape); it.More(); it.Next()) {
+            parts.Add(it.Value().Located(TopLoc_Location()));
+            ++nbInstances;
+        }
+    }
+    const bool instancing = nbInstances > parts.Extent();
+    
+    // write.step.assembly 是全局参数，转换结束（包括抛出异常）后恢复
     STEPControl_Writer writer;
-    IFSelect_ReturnStatus status = writer.Transfer(shape, STEPControl_AsIs);
+    IFSelect_ReturnStatus status = IFSelect_RetVoid;
+    {
+        StaticIntGuard assemblyMode("write.step.assembly");
+        if (instancing) {
+            assemblyMode.set(1);
+        }
+        status = writer.Transfer(shape, STEPControl_AsIs);
+    }
     
     if (status != IFSelect_RetDone) {
         return false;
     }
     
-    return writer.Write(filename.toStdString().c_str()) == IFSelect_RetDone;
+    const bool result = writer.Write(filename.toStdString().c_str()) == IFSelect_RetDone;
+    if (instancing) {
+        qDebug() << "FileIO::exportSTEP() - 装配实例化 零件:" << parts.Extent() << "实例:" << nbInstances
+                 << "大小(KB):" << QFileInfo(filename).size() / 1024 << "耗时(ms):" << timer.elapsed();
+    }
+    return result;
 }
 
 bool FileIO::exportIGES(const QString& filename, const TopoDS_Shape& shape)
@@ -171,28 +659,38 @@ bool FileIO::exportIGES(const QString& filename, const TopoDS_Shape& shape)
     return writer.Write(filename.toStdString().c_str()) == Standard_True;
 }
 
-bool FileIO::exportSTL(const QString& filename, const TopoDS_Shape& shape)
+bool FileIO::exportSTL(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options)
 {
-    StlAPI_Writer writer;
-    return writer.Write(shape, filename.toStdString().c_str()) == Standard_True;
+    // 并行剖分 + 按面并行填充二进制记录，一次写出
+    StlWriter writer;
+    writer.setDeflection(options.linearDeflection, options.angularDeflection);
+    writer.setThreadCount(options.threadCount);
+    return writer.write(filename, shape);
 }
 
-bool FileIO::exportOBJ(const QString& filename, const TopoDS_Shape& shape)
+bool FileIO::exportOBJ(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options)
 {
-    // OpenCascade不直接支持OBJ导出
-    qDebug() << "OBJ export not yet implemented";
-    return false;
+    // 流式导出：工作线程格式化文本，按顺序写入，内存占用限制在固定窗口内
+    ObjWriter writer;
+    writer.setDeflection(options.linearDeflection, options.angularDeflection);
+    writer.setThreadCount(options.threadCount);
+    return writer.write(filename, shape);
 }
 
-bool FileIO::exportGLTF(const QString& filename, const TopoDS_Shape& shape)
+bool FileIO::exportGLTF(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options)
 {
-    qDebug() << "GLTF export not yet implemented";
-    return false;
+    GltfWriter writer;
+    writer.setDeflection(options.linearDeflection, options.angularDeflection);
+    writer.setQuantization(options.quantize);
+    writer.setThreadCount(options.threadCount);
+    return writer.write(filename, shape, false);
 }
 
-bool FileIO::exportGLB(const QString& filename, const TopoDS_Shape& shape)
+bool FileIO::exportGLB(const QString& filename, const TopoDS_Shape& shape, const ExportOptions& options)
 {
-    qDebug() << "GLB export not yet implemented";
-    return false;
+    GltfWriter writer;
+    writer.setDeflection(options.linearDeflection, options.angularDeflection);
+    writer.setQuantization(options.quantize);
+    writer.setThreadCount(options.threadCount);
+    return writer.write(filename, shape, true);
 }
-
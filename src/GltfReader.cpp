@@ -0,0 +1,699 @@
+﻿#include "GltfReader.h"
+#include "FileIO.h"
+#include <OSD_Parallel.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Poly_ArrayOfNodes.hxx>
+#include <Poly_Triangle.hxx>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Quaternion.hxx>
+#include <gp_Mat.hxx>
+#include <gp_Vec3f.hxx>
+#include <Standard_Failure.hxx>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonParseError>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const quint32 THE_GLB_MAGIC      = 0x46546C67;  // "glTF"
+const quint32 THE_GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+const quint32 THE_GLB_CHUNK_BIN  = 0x004E4942;  // "BIN\0"
+
+enum GltfComponentType
+{
+    GltfByte          = 5120,
+    GltfUnsignedByte  = 5121,
+    GltfShort         = 5122,
+    GltfUnsignedShort = 5123,
+    GltfUnsignedInt   = 5125,
+    GltfFloat         = 5126
+};
+
+const int THE_GLTF_MODE_TRIANGLES = 4;
+
+// 映射的文件和解码后的 data URI 缓冲区，生命周期与引用它们的三角网格一致
+struct GltfBufferStore
+{
+    std::vector<std::unique_ptr<QFile>> files;
+    std::vector<QByteArray> decoded;
+    std::vector<const uchar*> data;     // 每个 buffer 的起始地址
+    std::vector<qint64> sizes;          // 每个 buffer 的字节数
+};
+
+// 持有缓冲区引用的三角网格，使直接映射的节点数组在网格存活期间一直有效
+class GltfTriangulation : public Poly_Triangulation
+{
+    DEFINE_STANDARD_RTTI_INLINE(GltfTriangulation, Poly_Triangulation)
+public:
+    explicit GltfTriangulation(const std::shared_ptr<GltfBufferStore>& store)
+        : m_store(store)
+    {
+    }
+
+private:
+    std::shared_ptr<GltfBufferStore> m_store;
+};
+
+// 已解析的访问器视图（只包含裸指针，可在工作线程中使用）
+struct GltfAccessor
+{
+    const uchar* data = nullptr;
+    int count = 0;
+    int componentType = 0;
+    int nbComponents = 0;
+    int stride = 0;
+    bool normalized = false;
+};
+
+// 单个三角形图元的解码任务
+struct GltfPrimitiveJob
+{
+    int mesh = -1;
+    GltfAccessor positions;
+    GltfAccessor indices;
+    bool hasIndices = false;
+    bool zeroCopy = false;
+    int nbTriangles = 0;
+    TopoDS_Face face;
+};
+
+// 列主序 4x4 矩阵
+struct GltfMatrix
+{
+    double m[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+
+    GltfMatrix operator*(const GltfMatrix& other) const
+    {
+        GltfMatrix result;
+        for (int col = 0; col < 4; ++col) {
+            for (int row = 0; row < 4; ++row) {
+                double sum = 0.0;
+                for (int k = 0; k < 4; ++k) {
+                    sum += m[k * 4 + row] * other.m[col * 4 + k];
+                }
+                result.m[col * 4 + row] = sum;
+            }
+        }
+        return result;
+    }
+
+    gp_Pnt transform(const gp_Pnt& p) const
+    {
+        return gp_Pnt(m[0] * p.X() + m[4] * p.Y() + m[8] * p.Z() + m[12],
+                      m[1] * p.X() + m[5] * p.Y() + m[9] * p.Z() + m[13],
+                      m[2] * p.X() + m[6] * p.Y() + m[10] * p.Z() + m[14]);
+    }
+
+    bool isIdentity() const
+    {
+        static const GltfMatrix identity;
+        for (int i = 0; i < 16; ++i) {
+            if (std::abs(m[i] - identity.m[i]) > 1.0e-12) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 转换为刚体变换（可带统一缩放），非统一缩放或错切时返回false
+    bool toTrsf(gp_Trsf& trsf) const
+    {
+        double scales[3];
+        for (int col = 0; col < 3; ++col) {
+            scales[col] = std::sqrt(m[col * 4] * m[col * 4] + m[col * 4 + 1] * m[col * 4 + 1]
+                                    + m[col * 4 + 2] * m[col * 4 + 2]);
+            if (scales[col] < 1.0e-12) {
+                return false;
+            }
+        }
+        const double tolerance = 1.0e-6 * scales[0];
+        if (std::abs(scales[0] - scales[1]) > tolerance || std::abs(scales[0] - scales[2]) > tolerance) {
+            return false;
+        }
+        for (int a = 0; a < 3; ++a) {
+            for (int b = a + 1; b < 3; ++b) {
+                double dot = m[a * 4] * m[b * 4] + m[a * 4 + 1] * m[b * 4 + 1] + m[a * 4 + 2] * m[b * 4 + 2];
+                if (std::abs(dot) > 1.0e-6 * scales[0] * scales[0]) {
+                    return false;
+                }
+            }
+        }
+        try {
+            trsf.SetValues(m[0], m[4], m[8],  m[12],
+                           m[1], m[5], m[9],  m[13],
+                           m[2], m[6], m[10], m[14]);
+        } catch (const Standard_Failure&) {
+            return false;
+        }
+        return true;
+    }
+};
+
+int componentSize(int componentType)
+{
+    switch (componentType) {
+    case GltfByte:
+    case GltfUnsignedByte:
+        return 1;
+    case GltfShort:
+    case GltfUnsignedShort:
+        return 2;
+    case GltfUnsignedInt:
+    case GltfFloat:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+int typeComponents(const QString& type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+float readComponent(const uchar* p, int componentType, bool normalized)
+{
+    switch (componentType) {
+    case GltfFloat: {
+        float value;
+        std::memcpy(&value, p, sizeof(float));
+        return value;
+    }
+    case GltfByte: {
+        const float value = float(qint8(*p));
+        return normalized ? std::max(value / 127.0f, -1.0f) : value;
+    }
+    case GltfUnsignedByte:
+        return normalized ? *p / 255.0f : float(*p);
+    case GltfShort: {
+        const float value = float(qFromLittleEndian<qint16>(p));
+        return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+    }
+    case GltfUnsignedShort: {
+        const float value = float(qFromLittleEndian<quint16>(p));
+        return normalized ? value / 65535.0f : value;
+    }
+    case GltfUnsignedInt:
+        return float(qFromLittleEndian<quint32>(p));
+    default:
+        return 0.0f;
+    }
+}
+
+quint32 readIndex(const uchar* p, int componentType)
+{
+    switch (componentType) {
+    case GltfUnsignedByte:
+        return *p;
+    case GltfUnsignedShort:
+        return qFromLittleEndian<quint16>(p);
+    case GltfUnsignedInt:
+        return qFromLittleEndian<quint32>(p);
+    default:
+        return 0;
+    }
+}
+
+qint64 jsonInt64(const QJsonObject& object, const char* key)
+{
+    return qint64(object.value(key).toDouble(0.0));
+}
+
+bool resolveAccessor(const QJsonObject& root, const GltfBufferStore& store, int index, GltfAccessor& accessor)
+{
+    const QJsonArray accessors = root.value("accessors").toArray();
+    if (index < 0 || index >= accessors.size()) {
+        return false;
+    }
+    const QJsonObject object = accessors.at(index).toObject();
+    if (object.contains("sparse") || !object.contains("bufferView")) {
+        return false;
+    }
+
+    const QJsonArray views = root.value("bufferViews").toArray();
+    const int viewIndex = object.value("bufferView").toInt(-1);
+    if (viewIndex < 0 || viewIndex >= views.size()) {
+        return false;
+    }
+    const QJsonObject view = views.at(viewIndex).toObject();
+    const int buffer = view.value("buffer").toInt(-1);
+    if (buffer < 0 || buffer >= int(store.data.size()) || store.data[buffer] == nullptr) {
+        return false;
+    }
+
+    accessor.componentType = object.value("componentType").toInt();
+    accessor.nbComponents = typeComponents(object.value("type").toString());
+    accessor.count = object.value("count").toInt();
+    accessor.normalized = object.value("normalized").toBool(false);
+    const int elementSize = componentSize(accessor.componentType) * accessor.nbComponents;
+    if (elementSize <= 0 || accessor.count <= 0) {
+        return false;
+    }
+    accessor.stride = view.value("byteStride").toInt(0);
+    if (accessor.stride == 0) {
+        accessor.stride = elementSize;
+    }
+
+    const qint64 viewOffset = jsonInt64(view, "byteOffset");
+    const qint64 viewLength = jsonInt64(view, "byteLength");
+    const qint64 offset = jsonInt64(object, "byteOffset");
+    if (viewOffset < 0 || offset < 0 || viewOffset + viewLength > store.sizes[buffer]
+        || offset + qint64(accessor.stride) * (accessor.count - 1) + elementSize > viewLength) {
+        return false;
+    }
+
+    accessor.data = store.data[buffer] + viewOffset + offset;
+    return true;
+}
+
+GltfMatrix nodeMatrix(const QJsonObject& node)
+{
+    GltfMatrix matrix;
+    const QJsonArray values = node.value("matrix").toArray();
+    if (values.size() == 16) {
+        for (int i = 0; i < 16; ++i) {
+            matrix.m[i] = values.at(i).toDouble();
+        }
+        return matrix;
+    }
+
+    // T * R * S
+    const QJsonArray t = node.value("translation").toArray();
+    const QJsonArray r = node.value("rotation").toArray();
+    const QJsonArray s = node.value("scale").toArray();
+    gp_Mat rotation;
+    rotation.SetIdentity();
+    if (r.size() == 4) {
+        gp_Quaternion q(r.at(0).toDouble(), r.at(1).toDouble(), r.at(2).toDouble(), r.at(3).toDouble());
+        q.Normalize();
+        rotation = q.GetMatrix();
+    }
+    double scale[3] = { 1.0, 1.0, 1.0 };
+    if (s.size() == 3) {
+        for (int i = 0; i < 3; ++i) {
+            scale[i] = s.at(i).toDouble(1.0);
+        }
+    }
+    for (int col = 0; col < 3; ++col) {
+        for (int row = 0; row < 3; ++row) {
+            matrix.m[col * 4 + row] = rotation.Value(row + 1, col + 1) * scale[col];
+        }
+    }
+    if (t.size() == 3) {
+        for (int i = 0; i < 3; ++i) {
+            matrix.m[12 + i] = t.at(i).toDouble();
+        }
+    }
+    return matrix;
+}
+
+bool loadBuffers(const QJsonObject& root, const QString& filename, const uchar* glbBin, qint64 glbBinSize,
+                 GltfBufferStore& store)
+{
+    const QJsonArray buffers = root.value("buffers").toArray();
+    const QDir baseDir = QFileInfo(filename).absoluteDir();
+
+    // 先解码全部 data URI，再记录地址，避免容器扩容使指针失效
+    std::vector<int> decodedIndex(buffers.size(), -1);
+    for (int i = 0; i < buffers.size(); ++i) {
+        const QString uri = buffers.at(i).toObject().value("uri").toString();
+        if (uri.startsWith("data:")) {
+            const int comma = uri.indexOf(',');
+            if (comma < 0) {
+                return false;
+            }
+            decodedIndex[i] = int(store.decoded.size());
+            store.decoded.push_back(QByteArray::fromBase64(uri.mid(comma + 1).toLatin1()));
+        }
+    }
+
+    store.data.assign(buffers.size(), nullptr);
+    store.sizes.assign(buffers.size(), 0);
+    for (int i = 0; i < buffers.size(); ++i) {
+        const QJsonObject buffer = buffers.at(i).toObject();
+        const QString uri = buffer.value("uri").toString();
+        if (uri.isEmpty()) {
+            // GLB 的 BIN 块
+            if (glbBin == nullptr) {
+                return false;
+            }
+            store.data[i] = glbBin;
+            store.sizes[i] = glbBinSize;
+        } else if (decodedIndex[i] >= 0) {
+            const QByteArray& bytes = store.decoded[decodedIndex[i]];
+            store.data[i] = reinterpret_cast<const uchar*>(bytes.constData());
+            store.sizes[i] = bytes.size();
+        } else {
+            // 外部 .bin 文件：只映射一次，写时复制，防止意外修改原文件
+            const QString path = baseDir.filePath(QUrl::fromPercentEncoding(uri.toUtf8()));
+            std::unique_ptr<QFile> file(new QFile(path));
+            if (!file->open(QIODevice::ReadOnly) || file->size() == 0) {
+                qWarning() << "GltfReader - 无法打开外部缓冲区:" << path;
+                return false;
+            }
+            const uchar* mapped = file->map(0, file->size(), QFileDevice::MapPrivateOption);
+            if (mapped == nullptr) {
+                return false;
+            }
+            store.data[i] = mapped;
+            store.sizes[i] = file->size();
+            store.files.push_back(std::move(file));
+        }
+
+        const qint64 declared = jsonInt64(buffer, "byteLength");
+        if (declared > store.sizes[i]) {
+            qWarning() << "GltfReader - 缓冲区长度不足:" << i;
+            return false;
+        }
+    }
+    return true;
+}
+
+void decodePrimitive(GltfPrimitiveJob& job, const std::shared_ptr<GltfBufferStore>& store)
+{
+    const GltfAccessor& positions = job.positions;
+    Handle(GltfTriangulation) triangulation = new GltfTriangulation(store);
+
+    const bool canAlias = positions.componentType == GltfFloat
+                       && positions.stride == int(sizeof(gp_Vec3f))
+                       && (reinterpret_cast<quintptr>(positions.data) % alignof(float)) == 0;
+    if (canAlias) {
+        // 零拷贝：节点数组直接指向映射的缓冲区
+        Poly_ArrayOfNodes wrapped(*reinterpret_cast<const gp_Vec3f*>(positions.data), positions.count);
+        triangulation->InternalNodes().Move(wrapped);
+        job.zeroCopy = true;
+    } else {
+        // 带步长或量化的位置只能转换后复制
+        triangulation->SetDoublePrecision(false);
+        triangulation->ResizeNodes(positions.count, false);
+        const int size = componentSize(positions.componentType);
+        for (int i = 0; i < positions.count; ++i) {
+            const uchar* p = positions.data + size_t(i) * positions.stride;
+            triangulation->SetNode(i + 1, gp_Pnt(readComponent(p, positions.componentType, positions.normalized),
+                                                 readComponent(p + size, positions.componentType, positions.normalized),
+                                                 readComponent(p + 2 * size, positions.componentType, positions.normalized)));
+        }
+    }
+
+    // OCCT 的三角形索引从1开始，索引数组必须转换
+    const int nbIndices = job.hasIndices ? job.indices.count : positions.count;
+    const int nbTriangles = nbIndices / 3;
+    if (nbTriangles == 0) {
+        return;
+    }
+    triangulation->ResizeTriangles(nbTriangles, false);
+    const quint32 nbNodes = quint32(positions.count);
+    for (int t = 0; t < nbTriangles; ++t) {
+        int nodes[3];
+        for (int k = 0; k < 3; ++k) {
+            const int i = t * 3 + k;
+            const quint32 index = job.hasIndices
+                ? readIndex(job.indices.data + size_t(i) * job.indices.stride, job.indices.componentType)
+                : quint32(i);
+            nodes[k] = index < nbNodes ? int(index) + 1 : 1;
+        }
+        triangulation->SetTriangle(t + 1, Poly_Triangle(nodes[0], nodes[1], nodes[2]));
+    }
+
+    BRep_Builder builder;
+    builder.MakeFace(job.face, triangulation);
+    job.nbTriangles = nbTriangles;
+}
+
+// 把变换直接烘焙到节点坐标中（用于非统一缩放的实例）
+TopoDS_Shape bakeInstance(const TopoDS_Shape& meshShape, const GltfMatrix& matrix)
+{
+    BRep_Builder builder;
+    TopoDS_Compound compound;
+    builder.MakeCompound(compound);
+    for (TopExp_Explorer explorer(meshShape, TopAbs_FACE); explorer.More(); explorer.Next()) {
+        TopLoc_Location location;
+        Handle(Poly_Triangulation) source = BRep_Tool::Triangulation(TopoDS::Face(explorer.Current()), location);
+        if (source.IsNull()) {
+            continue;
+        }
+        Handle(Poly_Triangulation) baked = new Poly_Triangulation(source->NbNodes(), source->NbTriangles(), Standard_False);
+        for (int i = 1; i <= source->NbNodes(); ++i) {
+            baked->SetNode(i, matrix.transform(source->Node(i)));
+        }
+        for (int i = 1; i <= source->NbTriangles(); ++i) {
+            baked->SetTriangle(i, source->Triangle(i));
+        }
+        TopoDS_Face bakedFace;
+        builder.MakeFace(bakedFace, baked);
+        builder.Add(compound, bakedFace);
+    }
+    return compound;
+}
+
+} // namespace
+
+GltfReader::GltfReader(int threadCount)
+    : m_threadCount(FileIO::resolveThreadCount(threadCount))
+{
+}
+
+bool GltfReader::read(const QString& filename)
+{
+    m_shape.Nullify();
+    m_stats = Statistics();
+
+    std::shared_ptr<GltfBufferStore> store = std::make_shared<GltfBufferStore>();
+
+    std::unique_ptr<QFile> file(new QFile(filename));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < 12) {
+        qWarning() << "GltfReader::read() - 无法打开文件:" << filename;
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument json;
+    const uchar* glbBin = nullptr;
+    qint64 glbBinSize = 0;
+
+    const qint64 fileSize = file->size();
+    const uchar* mapped = file->map(0, fileSize, QFileDevice::MapPrivateOption);
+    if (mapped == nullptr) {
+        qWarning() << "GltfReader::read() - 内存映射失败:" << file->errorString();
+        return false;
+    }
+
+    if (qFromLittleEndian<quint32>(mapped) == THE_GLB_MAGIC) {
+        // GLB：12字节文件头 + JSON 块 + 可选 BIN 块
+        if (qFromLittleEndian<quint32>(mapped + 4) != 2) {
+            qWarning() << "GltfReader::read() - 不支持的GLB版本";
+            return false;
+        }
+        qint64 offset = 12;
+        while (offset + 8 <= fileSize) {
+            const qint64 chunkLength = qFromLittleEndian<quint32>(mapped + offset);
+            const quint32 chunkType = qFromLittleEndian<quint32>(mapped + offset + 4);
+            const uchar* chunkData = mapped + offset + 8;
+            if (offset + 8 + chunkLength > fileSize) {
+                qWarning() << "GltfReader::read() - GLB块越界";
+                return false;
+            }
+            if (chunkType == THE_GLB_CHUNK_JSON && json.isNull()) {
+                json = QJsonDocument::fromJson(
+                    QByteArray::fromRawData(reinterpret_cast<const char*>(chunkData), int(chunkLength)), &parseError);
+            } else if (chunkType == THE_GLB_CHUNK_BIN && glbBin == nullptr) {
+                glbBin = chunkData;
+                glbBinSize = chunkLength;
+            }
+            offset += 8 + chunkLength;
+        }
+        store->files.push_back(std::move(file));
+    } else {
+        json = QJsonDocument::fromJson(
+            QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(fileSize)), &parseError);
+    }
+
+    if (json.isNull() || !json.isObject()) {
+        qWarning() << "GltfReader::read() - JSON解析失败:" << parseError.errorString();
+        return false;
+    }
+    const QJsonObject root = json.object();
+
+    if (!loadBuffers(root, filename, glbBin, glbBinSize, *store)) {
+        return false;
+    }
+
+    // 在主线程中把 JSON 解析成只含裸指针的任务列表
+    const QJsonArray meshes = root.value("meshes").toArray();
+    std::vector<GltfPrimitiveJob> jobs;
+    for (int m = 0; m < meshes.size(); ++m) {
+        const QJsonArray primitives = meshes.at(m).toObject().value("primitives").toArray();
+        for (const QJsonValue& value : primitives) {
+            const QJsonObject primitive = value.toObject();
+            if (primitive.value("mode").toInt(THE_GLTF_MODE_TRIANGLES) != THE_GLTF_MODE_TRIANGLES) {
+                continue;
+            }
+            if (primitive.contains("extensions")) {
+                // Draco / meshopt 等压缩扩展暂不支持
+                qWarning() << "GltfReader::read() - 跳过带扩展的图元，网格:" << m;
+                continue;
+            }
+            GltfPrimitiveJob job;
+            job.mesh = m;
+            const int positionIndex = primitive.value("attributes").toObject().value("POSITION").toInt(-1);
+            if (!resolveAccessor(root, *store, positionIndex, job.positions) || job.positions.nbComponents != 3) {
+                continue;
+            }
+            if (primitive.contains("indices")) {
+                if (!resolveAccessor(root, *store, primitive.value("indices").toInt(-1), job.indices)
+                    || job.indices.nbComponents != 1 || job.indices.componentType == GltfFloat) {
+                    continue;
+                }
+                job.hasIndices = true;
+            }
+            jobs.push_back(job);
+        }
+    }
+
+    // 并行解码所有图元
+    QElapsedTimer timer;
+    timer.start();
+    OSD_Parallel::For(0, int(jobs.size()), [&jobs, &store](int i) {
+        decodePrimitive(jobs[i], store);
+    }, m_threadCount == 1);
+    m_stats.decodeMs = timer.elapsed();
+
+    // 每个网格只生成一个形状，供所有引用它的节点共享
+    BRep_Builder builder;
+    std::vector<TopoDS_Shape> meshShapes(meshes.size());
+    std::vector<int> meshFaceCount(meshes.size(), 0);
+    std::vector<TopoDS_Compound> meshCompounds(meshes.size());
+    for (const GltfPrimitiveJob& job : jobs) {
+        if (job.face.IsNull()) {
+            continue;
+        }
+        ++m_stats.nbPrimitives;
+        m_stats.nbTriangles += job.nbTriangles;
+        if (job.zeroCopy) {
+            ++m_stats.nbZeroCopy;
+        }
+        if (meshFaceCount[job.mesh]++ == 0) {
+            meshShapes[job.mesh] = job.face;
+            builder.MakeCompound(meshCompounds[job.mesh]);
+        }
+        builder.Add(meshCompounds[job.mesh], job.face);
+    }
+    for (int m = 0; m < meshes.size(); ++m) {
+        if (meshFaceCount[m] > 1) {
+            meshShapes[m] = meshCompounds[m];
+        }
+        if (meshFaceCount[m] > 0) {
+            ++m_stats.nbMeshes;
+        }
+    }
+
+    // 遍历场景节点，计算世界变换并生成实例
+    TopoDS_Compound result;
+    builder.MakeCompound(result);
+    const QJsonArray nodes = root.value("nodes").toArray();
+
+    QList<int> rootNodes;
+    const QJsonArray scenes = root.value("scenes").toArray();
+    const int sceneIndex = root.value("scene").toInt(0);
+    if (sceneIndex >= 0 && sceneIndex < scenes.size()) {
+        for (const QJsonValue& value : scenes.at(sceneIndex).toObject().value("nodes").toArray()) {
+            rootNodes.append(value.toInt(-1));
+        }
+    } else {
+        // 没有场景时，所有不是子节点的节点都作为根
+        std::vector<bool> isChild(nodes.size(), false);
+        for (const QJsonValue& node : nodes) {
+            for (const QJsonValue& child : node.toObject().value("children").toArray()) {
+                const int c = child.toInt(-1);
+                if (c >= 0 && c < nodes.size()) {
+                    isChild[c] = true;
+                }
+            }
+        }
+        for (int n = 0; n < nodes.size(); ++n) {
+            if (!isChild[n]) {
+                rootNodes.append(n);
+            }
+        }
+    }
+
+    struct PendingNode
+    {
+        int index;
+        GltfMatrix parent;
+        int depth;
+    };
+    QList<PendingNode> stack;
+    for (int n : rootNodes) {
+        stack.append({ n, GltfMatrix(), 0 });
+    }
+    while (!stack.isEmpty()) {
+        const PendingNode pending = stack.takeLast();
+        if (pending.index < 0 || pending.index >= nodes.size() || pending.depth > nodes.size()) {
+            continue;
+        }
+        const QJsonObject node = nodes.at(pending.index).toObject();
+        const GltfMatrix world = pending.parent * nodeMatrix(node);
+
+        const int mesh = node.value("mesh").toInt(-1);
+        if (mesh >= 0 && mesh < meshes.size() && !meshShapes[mesh].IsNull()) {
+            gp_Trsf trsf;
+            if (world.isIdentity()) {
+                builder.Add(result, meshShapes[mesh]);
+            } else if (world.toTrsf(trsf)) {
+                builder.Add(result, meshShapes[mesh].Located(TopLoc_Location(trsf)));
+            } else {
+                builder.Add(result, bakeInstance(meshShapes[mesh], world));
+            }
+            ++m_stats.nbInstances;
+        }
+
+        for (const QJsonValue& child : node.value("children").toArray()) {
+            stack.append({ child.toInt(-1), world, pending.depth + 1 });
+        }
+    }
+
+    // 没有任何节点引用网格时，直接输出所有网格
+    if (m_stats.nbInstances == 0) {
+        for (const TopoDS_Shape& meshShape : meshShapes) {
+            if (!meshShape.IsNull()) {
+                builder.Add(result, meshShape);
+            }
+        }
+    }
+
+    qDebug() << "GltfReader::read() -" << filename
+             << "网格:" << m_stats.nbMeshes << "图元:" << m_stats.nbPrimitives
+             << "实例:" << m_stats.nbInstances << "零拷贝图元:" << m_stats.nbZeroCopy
+             << "三角形:" << m_stats.nbTriangles << "解码(ms):" << m_stats.decodeMs;
+
+    if (m_stats.nbPrimitives == 0) {
+        return false;
+    }
+    m_shape = result;
+    return true;
+}
@@ -0,0 +1,607 @@
+﻿#include "GltfWriter.h"
+#include "FileIO.h"
+#include <OSD_Parallel.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepLib_ToolTriangulatedShape.hxx>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopoDS_TShape.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Dir.hxx>
+#include <gp.hxx>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const quint32 THE_GLB_MAGIC      = 0x46546C67;  // "glTF"
+const quint32 THE_GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+const quint32 THE_GLB_CHUNK_BIN  = 0x004E4942;  // "BIN\0"
+
+const int THE_TARGET_ARRAY_BUFFER         = 34962;
+const int THE_TARGET_ELEMENT_ARRAY_BUFFER = 34963;
+
+const int THE_COMPONENT_SHORT          = 5122;
+const int THE_COMPONENT_UNSIGNED_SHORT = 5123;
+const int THE_COMPONENT_UNSIGNED_INT   = 5125;
+const int THE_COMPONENT_FLOAT          = 5126;
+
+const float THE_SHORT_MAX = 32767.0f;
+
+// 顶点去重键：位置和法线的位模式
+struct VertexKey
+{
+    quint32 bits[6];
+
+    bool operator==(const VertexKey& other) const
+    {
+        return std::memcmp(bits, other.bits, sizeof(bits)) == 0;
+    }
+};
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey& key) const
+    {
+        size_t hash = 0;
+        for (quint32 value : key.bits) {
+            hash = hash * 1000003u ^ value;
+        }
+        return hash;
+    }
+};
+
+// 一个唯一的网格（对应一个 TShape + 方向）
+struct GltfPart
+{
+    TopoDS_Shape shape;                 // 去掉位置后的形状
+    std::vector<float> positions;       // 合并后的顶点
+    std::vector<float> normals;
+    std::vector<quint32> indices;
+    float min[3] = { 0.0f, 0.0f, 0.0f };
+    float max[3] = { 0.0f, 0.0f, 0.0f };
+    int nbMerged = 0;
+
+    // 量化参数：局部坐标 = center + scale * 归一化值
+    gp_XYZ center;
+    double scale = 1.0;
+    qint16 quantMin[3] = { 0, 0, 0 };
+    qint16 quantMax[3] = { 0, 0, 0 };
+
+    // 缓冲区布局
+    qint64 positionOffset = 0;
+    qint64 normalOffset = 0;
+    qint64 indexOffset = 0;
+    qint64 positionBytes = 0;
+    qint64 normalBytes = 0;
+    qint64 indexBytes = 0;
+    bool shortIndices = false;
+};
+
+struct GltfInstance
+{
+    int part;
+    gp_Trsf trsf;
+};
+
+inline qint64 align4(qint64 value)
+{
+    return (value + 3) & ~qint64(3);
+}
+
+inline qint16 quantizeUnit(double value)
+{
+    return qint16(std::lround(std::max(-1.0, std::min(1.0, value)) * THE_SHORT_MAX));
+}
+
+// 展开复合体，按 TShape 和方向归并实例
+void collectInstances(const TopoDS_Shape& shape,
+                      std::map<std::pair<const TopoDS_TShape*, int>, int>& partIndex,
+                      std::vector<GltfPart>& parts,
+                      std::vector<GltfInstance>& instances)
+{
+    if (shape.IsNull()) {
+        return;
+    }
+    if (shape.ShapeType() == TopAbs_COMPOUND) {
+        // TopoDS_Iterator 默认累积位置和方向
+        for (TopoDS_Iterator it(shape); it.More(); it.Next()) {
+            collectInstances(it.Value(), partIndex, parts, instances);
+        }
+        return;
+    }
+
+    const std::pair<const TopoDS_TShape*, int> key(shape.TShape().get(), int(shape.Orientation()));
+    auto found = partIndex.find(key);
+    int index = 0;
+    if (found == partIndex.end()) {
+        index = int(parts.size());
+        partIndex.emplace(key, index);
+        parts.emplace_back();
+        parts.back().shape = shape.Located(TopLoc_Location());
+    } else {
+        index = found->second;
+    }
+    instances.push_back({ index, shape.Location().Transformation() });
+}
+
+// 收集一个已剖分网格的顶点并合并位置和法线都相同的顶点，只读访问面的三角剖分
+void gatherPart(GltfPart& part, bool quantize)
+{
+    std::unordered_map<VertexKey, quint32, VertexKeyHash> merged;
+    std::vector<quint32> remap;
+    for (TopExp_Explorer explorer(part.shape, TopAbs_FACE); explorer.More(); explorer.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(explorer.Current());
+        TopLoc_Location location;
+        Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(face, location);
+        if (triangulation.IsNull() || triangulation->NbTriangles() == 0) {
+            continue;
+        }
+
+        const gp_Trsf trsf = location.Transformation();
+        const bool mirrored = trsf.VectorialPart().Determinant() < 0.0;
+        const bool reversed = (face.Orientation() == TopAbs_REVERSED) != mirrored;
+
+        remap.assign(triangulation->NbNodes() + 1, 0);
+        for (int i = 1; i <= triangulation->NbNodes(); ++i) {
+            const gp_Pnt point = triangulation->Node(i).Transformed(trsf);
+            gp_Dir normal = triangulation->HasNormals() ? triangulation->Normal(i) : gp::DZ();
+            normal.Transform(trsf);
+            if (reversed) {
+                normal.Reverse();
+            }
+
+            const float values[6] = { float(point.X()), float(point.Y()), float(point.Z()),
+                                      float(normal.X()), float(normal.Y()), float(normal.Z()) };
+            VertexKey key;
+            std::memcpy(key.bits, values, sizeof(values));
+            auto inserted = merged.emplace(key, quint32(part.positions.size() / 3));
+            if (inserted.second) {
+                part.positions.insert(part.positions.end(), values, values + 3);
+                part.normals.insert(part.normals.end(), values + 3, values + 6);
+            } else {
+                ++part.nbMerged;
+            }
+            remap[i] = inserted.first->second;
+        }
+
+        for (int t = 1; t <= triangulation->NbTriangles(); ++t) {
+            Standard_Integer n1, n2, n3;
+            triangulation->Triangle(t).Get(n1, n2, n3);
+            if (reversed) {
+                std::swap(n2, n3);
+            }
+            part.indices.push_back(remap[n1]);
+            part.indices.push_back(remap[n2]);
+            part.indices.push_back(remap[n3]);
+        }
+    }
+
+    const size_t nbVertices = part.positions.size() / 3;
+    if (nbVertices == 0) {
+        return;
+    }
+    for (int c = 0; c < 3; ++c) {
+        part.min[c] = part.max[c] = part.positions[c];
+    }
+    for (size_t v = 1; v < nbVertices; ++v) {
+        for (int c = 0; c < 3; ++c) {
+            part.min[c] = std::min(part.min[c], part.positions[v * 3 + c]);
+            part.max[c] = std::max(part.max[c], part.positions[v * 3 + c]);
+        }
+    }
+
+    if (quantize) {
+        // 统一缩放，避免节点矩阵中的非统一缩放扭曲法线
+        double halfExtent = 0.0;
+        for (int c = 0; c < 3; ++c) {
+            part.center.SetCoord(c + 1, 0.5 * (double(part.min[c]) + double(part.max[c])));
+            halfExtent = std::max(halfExtent, 0.5 * (double(part.max[c]) - double(part.min[c])));
+        }
+        part.scale = halfExtent > 1.0e-12 ? halfExtent : 1.0;
+        for (int c = 0; c < 3; ++c) {
+            part.quantMin[c] = quantizeUnit((part.min[c] - part.center.Coord(c + 1)) / part.scale);
+            part.quantMax[c] = quantizeUnit((part.max[c] - part.center.Coord(c + 1)) / part.scale);
+        }
+    }
+}
+
+// 带缓冲的顺序写出
+class BinarySink
+{
+public:
+    explicit BinarySink(QFile& file)
+        : m_file(file)
+        , m_written(0)
+        , m_ok(true)
+    {
+        m_buffer.reserve(THE_CAPACITY);
+    }
+
+    ~BinarySink()
+    {
+        flush();
+    }
+
+    void append(const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        m_written += qint64(size);
+        if (m_buffer.size() >= THE_CAPACITY) {
+            flush();
+        }
+    }
+
+    template <typename T>
+    void appendValue(T value)
+    {
+        const T littleEndian = qToLittleEndian(value);
+        append(&littleEndian, sizeof(T));
+    }
+
+    void pad(qint64 alignedSize, char fill)
+    {
+        while (m_written < alignedSize) {
+            append(&fill, 1);
+        }
+    }
+
+    bool flush()
+    {
+        if (!m_buffer.empty()) {
+            m_ok = m_ok && m_file.write(m_buffer.data(), qint64(m_buffer.size())) == qint64(m_buffer.size());
+            m_buffer.clear();
+        }
+        return m_ok;
+    }
+
+    qint64 written() const { return m_written; }
+
+private:
+    static const size_t THE_CAPACITY = 1 << 20;
+
+    QFile& m_file;
+    std::vector<char> m_buffer;
+    qint64 m_written;
+    bool m_ok;
+};
+
+void writePart(BinarySink& sink, const GltfPart& part, bool quantize, qint64 base)
+{
+    const size_t nbVertices = part.positions.size() / 3;
+    const qint16 zero = 0;
+
+    for (size_t v = 0; v < nbVertices; ++v) {
+        if (quantize) {
+            for (int c = 0; c < 3; ++c) {
+                sink.appendValue<qint16>(quantizeUnit((part.positions[v * 3 + c] - part.center.Coord(c + 1)) / part.scale));
+            }
+            sink.appendValue<qint16>(zero);
+        } else {
+            for (int c = 0; c < 3; ++c) {
+                sink.appendValue<float>(part.positions[v * 3 + c]);
+            }
+        }
+    }
+    for (size_t v = 0; v < nbVertices; ++v) {
+        if (quantize) {
+            for (int c = 0; c < 3; ++c) {
+                sink.appendValue<qint16>(quantizeUnit(part.normals[v * 3 + c]));
+            }
+            sink.appendValue<qint16>(zero);
+        } else {
+            for (int c = 0; c < 3; ++c) {
+                sink.appendValue<float>(part.normals[v * 3 + c]);
+            }
+        }
+    }
+    for (quint32 index : part.indices) {
+        if (part.shortIndices) {
+            sink.appendValue<quint16>(quint16(index));
+        } else {
+            sink.appendValue<quint32>(index);
+        }
+    }
+    sink.pad(base + part.indexOffset + align4(part.indexBytes), '\0');
+}
+
+QJsonArray toJsonArray(const float values[3])
+{
+    return QJsonArray{ double(values[0]), double(values[1]), double(values[2]) };
+}
+
+QJsonArray toJsonArray(const qint16 values[3])
+{
+    return QJsonArray{ int(values[0]), int(values[1]), int(values[2]) };
+}
+
+QJsonObject bufferView(qint64 offset, qint64 length, int stride, int target)
+{
+    QJsonObject view;
+    view["buffer"] = 0;
+    view["byteOffset"] = double(offset);
+    view["byteLength"] = double(length);
+    if (stride > 0) {
+        view["byteStride"] = stride;
+    }
+    view["target"] = target;
+    return view;
+}
+
+} // namespace
+
+GltfWriter::GltfWriter()
+    : m_linearDeflection(0.1)
+    , m_angularDeflection(0.5)
+    , m_quantize(false)
+    , m_threadCount(0)
+{
+}
+
+bool GltfWriter::write(const QString& filename, const TopoDS_Shape& shape, bool binary)
+{
+    m_stats = Statistics();
+    if (shape.IsNull()) {
+        return false;
+    }
+
+    // 按 TShape 收集唯一网格和实例
+    std::map<std::pair<const TopoDS_TShape*, int>, int> partIndex;
+    std::vector<GltfPart> parts;
+    std::vector<GltfInstance> instances;
+    collectInstances(shape, partIndex, parts, instances);
+
+    // 全部唯一网格放入一个复合体统一剖分一次：同一 TShape 的正反两个方向、
+    // 以及共享面的布尔结果引用同一个 TFace，不能在各工作线程中分别剖分
+    QElapsedTimer timer;
+    timer.start();
+    const bool singleThread = FileIO::resolveThreadCount(m_threadCount) == 1;
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    for (const GltfPart& part : parts) {
+        builder.Add(compound, part.shape);
+    }
+    BRepMesh_IncrementalMesh mesher(compound, m_linearDeflection, Standard_False, m_angularDeflection, !singleThread);
+
+    // 法线也写回面的三角剖分，按 TFace 去重后再并行计算
+    std::vector<TopoDS_Face> faces;
+    std::unordered_set<const TopoDS_TShape*> visited;
+    for (TopExp_Explorer explorer(compound, TopAbs_FACE); explorer.More(); explorer.Next()) {
+        if (visited.insert(explorer.Current().TShape().get()).second) {
+            faces.push_back(TopoDS::Face(explorer.Current()));
+        }
+    }
+    OSD_Parallel::For(0, int(faces.size()), [&faces](int i) {
+        TopLoc_Location location;
+        Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(faces.at(i), location);
+        if (!triangulation.IsNull() && triangulation->NbTriangles() > 0 && !triangulation->HasNormals()) {
+            BRepLib_ToolTriangulatedShape::ComputeNormals(faces.at(i), triangulation);
+        }
+    }, singleThread);
+
+    // 并行收集顶点、合并并量化
+    const bool quantize = m_quantize;
+    OSD_Parallel::For(0, int(parts.size()), [&parts, quantize](int i) {
+        gatherPart(parts[i], quantize);
+    }, singleThread);
+    m_stats.meshMs = timer.restart();
+
+    // 预先计算缓冲区布局，使 JSON 可以在二进制数据之前写出
+    QJsonArray bufferViews;
+    QJsonArray accessors;
+    QJsonArray meshes;
+    std::vector<int> meshOfPart(parts.size(), -1);
+    qint64 binaryLength = 0;
+    const int vertexStride = quantize ? 4 * int(sizeof(qint16)) : 3 * int(sizeof(float));
+    for (size_t p = 0; p < parts.size(); ++p) {
+        GltfPart& part = parts[p];
+        const qint64 nbVertices = qint64(part.positions.size() / 3);
+        if (nbVertices == 0 || part.indices.empty()) {
+            continue;
+        }
+        part.shortIndices = nbVertices <= 0xFFFF;
+        part.positionOffset = binaryLength;
+        part.positionBytes = nbVertices * vertexStride;
+        part.normalOffset = part.positionOffset + part.positionBytes;
+        part.normalBytes = nbVertices * vertexStride;
+        part.indexOffset = part.normalOffset + part.normalBytes;
+        part.indexBytes = qint64(part.indices.size()) * (part.shortIndices ? 2 : 4);
+        binaryLength = part.indexOffset + align4(part.indexBytes);
+
+        const int viewIndex = bufferViews.size();
+        bufferViews.append(bufferView(part.positionOffset, part.positionBytes, vertexStride, THE_TARGET_ARRAY_BUFFER));
+        bufferViews.append(bufferView(part.normalOffset, part.normalBytes, vertexStride, THE_TARGET_ARRAY_BUFFER));
+        bufferViews.append(bufferView(part.indexOffset, part.indexBytes, 0, THE_TARGET_ELEMENT_ARRAY_BUFFER));
+
+        const int accessorIndex = accessors.size();
+        QJsonObject position;
+        position["bufferView"] = viewIndex;
+        position["count"] = double(nbVertices);
+        position["type"] = "VEC3";
+        QJsonObject normal;
+        normal["bufferView"] = viewIndex + 1;
+        normal["count"] = double(nbVertices);
+        normal["type"] = "VEC3";
+        if (quantize) {
+            position["componentType"] = THE_COMPONENT_SHORT;
+            position["normalized"] = true;
+            position["min"] = toJsonArray(part.quantMin);
+            position["max"] = toJsonArray(part.quantMax);
+            normal["componentType"] = THE_COMPONENT_SHORT;
+            normal["normalized"] = true;
+        } else {
+            position["componentType"] = THE_COMPONENT_FLOAT;
+            position["min"] = toJsonArray(part.min);
+            position["max"] = toJsonArray(part.max);
+            normal["componentType"] = THE_COMPONENT_FLOAT;
+        }
+        QJsonObject index;
+        index["bufferView"] = viewIndex + 2;
+        index["componentType"] = part.shortIndices ? THE_COMPONENT_UNSIGNED_SHORT : THE_COMPONENT_UNSIGNED_INT;
+        index["count"] = double(part.indices.size());
+        index["type"] = "SCALAR";
+        accessors.append(position);
+        accessors.append(normal);
+        accessors.append(index);
+
+        QJsonObject attributes;
+        attributes["POSITION"] = accessorIndex;
+        attributes["NORMAL"] = accessorIndex + 1;
+        QJsonObject primitive;
+        primitive["attributes"] = attributes;
+        primitive["indices"] = accessorIndex + 2;
+        primitive["mode"] = 4;
+        QJsonObject mesh;
+        mesh["primitives"] = QJsonArray{ primitive };
+
+        meshOfPart[p] = meshes.size();
+        meshes.append(mesh);
+        m_stats.nbVertices += int(nbVertices);
+        m_stats.nbTriangles += int(part.indices.size() / 3);
+        m_stats.nbMergedVertices += part.nbMerged;
+    }
+    m_stats.nbMeshes = meshes.size();
+    m_stats.binaryBytes = binaryLength;
+
+    if (meshes.isEmpty()) {
+        qWarning() << "GltfWriter::write() - 没有可导出的三角网格";
+        return false;
+    }
+
+    // 每个实例一个节点；量化时把反量化变换并入节点矩阵
+    QJsonArray nodes;
+    QJsonArray sceneNodes;
+    for (const GltfInstance& instance : instances) {
+        const GltfPart& part = parts[instance.part];
+        if (meshOfPart[instance.part] < 0) {
+            continue;
+        }
+        gp_Trsf trsf = instance.trsf;
+        if (quantize) {
+            gp_Trsf dequantize;
+            dequantize.SetScale(gp::Origin(), part.scale);
+            dequantize.SetTranslationPart(gp_Vec(part.center));
+            trsf.Multiply(dequantize);
+        }
+        QJsonObject node;
+        node["mesh"] = meshOfPart[instance.part];
+        if (trsf.Form() != gp_Identity) {
+            QJsonArray matrix;
+            for (int col = 1; col <= 4; ++col) {
+                for (int row = 1; row <= 3; ++row) {
+                    matrix.append(trsf.Value(row, col));
+                }
+                matrix.append(col == 4 ? 1.0 : 0.0);
+            }
+            node["matrix"] = matrix;
+        }
+        sceneNodes.append(nodes.size());
+        nodes.append(node);
+    }
+    m_stats.nbInstances = nodes.size();
+
+    QJsonObject asset;
+    asset["version"] = "2.0";
+    asset["generator"] = "MyCad";
+    QJsonObject buffer;
+    buffer["byteLength"] = double(binaryLength);
+    const QFileInfo fileInfo(filename);
+    const QString binaryName = fileInfo.completeBaseName() + ".bin";
+    if (!binary) {
+        buffer["uri"] = binaryName;
+    }
+    QJsonObject scene;
+    scene["nodes"] = sceneNodes;
+
+    QJsonObject root;
+    root["asset"] = asset;
+    if (quantize) {
+        root["extensionsUsed"] = QJsonArray{ "KHR_mesh_quantization" };
+        root["extensionsRequired"] = QJsonArray{ "KHR_mesh_quantization" };
+    }
+    root["buffers"] = QJsonArray{ buffer };
+    root["bufferViews"] = bufferViews;
+    root["accessors"] = accessors;
+    root["meshes"] = meshes;
+    root["nodes"] = nodes;
+    root["scenes"] = QJsonArray{ scene };
+    root["scene"] = 0;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "GltfWriter::write() - 无法写入文件:" << filename;
+        return false;
+    }
+
+    bool ok = true;
+    if (binary) {
+        // GLB：文件头、JSON 块、BIN 块一次顺序写出
+        const qint64 jsonLength = align4(json.size());
+        const qint64 totalLength = 12 + 8 + jsonLength + 8 + binaryLength;
+        BinarySink sink(file);
+        sink.appendValue<quint32>(THE_GLB_MAGIC);
+        sink.appendValue<quint32>(2);
+        sink.appendValue<quint32>(quint32(totalLength));
+        sink.appendValue<quint32>(quint32(jsonLength));
+        sink.appendValue<quint32>(THE_GLB_CHUNK_JSON);
+        sink.append(json.constData(), size_t(json.size()));
+        sink.pad(20 + jsonLength, ' ');
+        sink.appendValue<quint32>(quint32(binaryLength));
+        sink.appendValue<quint32>(THE_GLB_CHUNK_BIN);
+        const qint64 base = sink.written();
+        for (const GltfPart& part : parts) {
+            if (!part.indices.empty()) {
+                writePart(sink, part, quantize, base);
+            }
+        }
+        ok = sink.flush() && sink.written() == totalLength;
+    } else {
+        // glTF：JSON 文件 + 同名 .bin 文件
+        ok = file.write(json) == json.size();
+        QFile binaryFile(fileInfo.absoluteDir().filePath(binaryName));
+        if (!binaryFile.open(QIODevice::WriteOnly)) {
+            qWarning() << "GltfWriter::write() - 无法写入缓冲区文件:" << binaryFile.fileName();
+            return false;
+        }
+        BinarySink sink(binaryFile);
+        for (const GltfPart& part : parts) {
+            if (!part.indices.empty()) {
+                writePart(sink, part, quantize, 0);
+            }
+        }
+        ok = sink.flush() && ok && sink.written() == binaryLength;
+    }
+    m_stats.writeMs = timer.elapsed();
+
+    qDebug() << "GltfWriter::write() -" << filename
+             << "网格:" << m_stats.nbMeshes << "实例:" << m_stats.nbInstances
+             << "顶点:" << m_stats.nbVertices << "合并顶点:" << m_stats.nbMergedVertices
+             << "三角形:" << m_stats.nbTriangles << "缓冲区(KB):" << m_stats.binaryBytes / 1024
+             << "量化:" << quantize << "剖分(ms):" << m_stats.meshMs << "写入(ms):" << m_stats.writeMs;
+    return ok;
+}
@@ -0,0 +1,257 @@
+﻿#include "IgesReader.h"
+#include "FileIO.h"
+#include "SharedGraphSession.h"
+#include <IGESControl_Reader.hxx>
+#include <IGESData_IGESModel.hxx>
+#include <IGESData_IGESEntity.hxx>
+#include <IGESToBRep_Actor.hxx>
+#include <IGESToBRep.hxx>
+#include <Interface_Graph.hxx>
+#include <Interface_EntityIterator.hxx>
+#include <XSControl_WorkSession.hxx>
+#include <XSControl_TransferReader.hxx>
+#include <Interface_Static.hxx>
+#include <OSD_Parallel.hxx>
+#include <Message_ProgressScope.hxx>
+#include <BRepBuilderAPI_Sewing.hxx>
+#include <BRep_Builder.hxx>
+#include <ShapeFix_Face.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_IndexedDataMapOfShapeListOfShape.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <Standard_Failure.hxx>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// 只有不含壳（或实体）的散面结果参与缝合，曲线等不含面的结果原样保留
+bool needsSewing(const TopoDS_Shape& shape, double tolerance)
+{
+    return tolerance > 0.0
+        && !TopExp_Explorer(shape, TopAbs_SHELL).More()
+        && TopExp_Explorer(shape, TopAbs_FACE).More();
+}
+
+// 根实体是否引用同一个几何实体（曲线、曲面或拓扑实体，如多个实例共用的子图定义成员）；
+// 共享的实体在不同线程中会各自转换成互不共享的重复形状，此时只能在一个会话中串行转换
+// 颜色、图层、变换矩阵等不生成形状的实体不计入
+bool rootsShareEntities(IGESControl_Reader& reader, const Interface_Graph& graph, Standard_Integer nbRoots)
+{
+    // 不生成形状的共享实体（如子图定义）仍要继续展开，其成员可能是共享的几何
+    std::unordered_map<const Standard_Transient*, Standard_Integer> ownerRoot;
+    for (Standard_Integer root = 1; root <= nbRoots; ++root) {
+        std::unordered_set<const Standard_Transient*> visited;
+        std::vector<Handle(Standard_Transient)> pending(1, reader.RootForTransfer(root));
+        while (!pending.empty()) {
+            Handle(Standard_Transient) entity = pending.back();
+            pending.pop_back();
+            if (entity.IsNull() || !visited.insert(entity.get()).second) {
+                continue;
+            }
+            auto inserted = ownerRoot.emplace(entity.get(), root);
+            if (!inserted.second && inserted.first->second != root) {
+                Handle(IGESData_IGESEntity) igesEntity = Handle(IGESData_IGESEntity)::DownCast(entity);
+                if (!igesEntity.IsNull()
+                    && (IGESToBRep::IsCurveAndSurface(igesEntity) || IGESToBRep::IsBRepEntity(igesEntity))) {
+                    return true;
+                }
+            }
+            Interface_EntityIterator shareds = graph.Shareds(entity);
+            for (shareds.Start(); shareds.More(); shareds.Next()) {
+                pending.push_back(shareds.Value());
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+IgesReader::IgesReader(int threadCount)
+    : m_threadCount(FileIO::resolveThreadCount(threadCount))
+    , m_sewingTolerance(0.01)
+{
+}
+
+bool IgesReader::read(const QString& filename, const Message_ProgressRange& progress)
+{
+    m_shape.Nullify();
+    m_stats = Statistics();
+
+    // 进度：解析 1，转换 5，修复 1，缝合 3
+    Message_ProgressScope scope(progress, "IGES", 10);
+    QElapsedTimer timer;
+    timer.start();
+
+    IGESControl_Reader reader;
+    if (reader.ReadFile(filename.toStdString().c_str()) != IFSelect_RetDone) {
+        qWarning() << "IgesReader::read() - 无法解析文件:" << filename;
+        return false;
+    }
+    if (!scope.More()) {
+        return false;
+    }
+    scope.Next();
+    m_stats.readMs = timer.restart();
+
+    const Standard_Integer nbRoots = reader.NbRootsForTransfer();
+    m_stats.nbRoots = nbRoots;
+    if (nbRoots == 0) {
+        qWarning() << "IgesReader::read() - 没有可转换的实体:" << filename;
+        return false;
+    }
+
+    // 各工作线程拥有独立的会话、读取器和转换器实例，共享已解析的模型和主读取器建好的实体图，
+    // 按轮询方式分配根实体；根实体共享几何实体时只用一个线程，共享的部分只转换一次
+    Handle(Interface_InterfaceModel) model = reader.Model();
+    Handle(Interface_HGraph) graph = reader.WS()->HGraph();
+    const bool shared = nbRoots > 1 && m_threadCount > 1 && rootsShareEntities(reader, graph->Graph(), nbRoots);
+    const int nbWorkers = shared ? 1 : std::min(m_threadCount, int(nbRoots));
+    m_stats.nbWorkers = nbWorkers;
+    m_stats.sharedEntities = shared;
+    
+    // 模型级的状态在进入并行区之前只准备一次：实体图由主读取器建好，全局段（单位、分辨率）
+    // 在解析时已确定，转换器只读取；连续性参数在这里读出，工作线程中不再访问 Interface_Static
+    Handle(IGESData_IGESModel) igesModel = Handle(IGESData_IGESModel)::DownCast(model);
+    const Standard_Integer continuity = Interface_Static::IVal("read.iges.bspline.continuity");
+
+    Message_ProgressScope transferScope(scope.Next(5), "转换", nbRoots);
+    std::vector<Message_ProgressRange> ranges;
+    ranges.reserve(nbRoots);
+    for (Standard_Integer root = 1; root <= nbRoots; ++root) {
+        ranges.push_back(transferScope.Next());
+    }
+
+    std::vector<TopoDS_Shape> results(nbRoots);
+    OSD_Parallel::For(0, nbWorkers, [&](int worker) {
+        Handle(SharedGraphSession) session = new SharedGraphSession();
+        IGESControl_Reader workerReader(session, Standard_False);
+        session->SetModel(model);
+        session->shareGraph(graph);
+        session->InitTransferReader(4);
+
+        // 控制器默认在所有会话间共享同一个转换器，这里为每个线程单独创建
+        Handle(IGESToBRep_Actor) actor = new IGESToBRep_Actor();
+        actor->SetModel(igesModel);
+        actor->SetContinuity(continuity);
+        session->TransferReader()->SetActor(actor);
+
+        for (Standard_Integer root = worker + 1; root <= nbRoots; root += nbWorkers) {
+            if (ranges[root - 1].UserBreak()) {
+                break;
+            }
+            try {
+                const Standard_Integer nbBefore = workerReader.NbShapes();
+                workerReader.TransferOneRoot(root, ranges[root - 1]);
+                if (workerReader.NbShapes() > nbBefore) {
+                    results[root - 1] = workerReader.Shape(workerReader.NbShapes());
+                    if (m_partCallback && !needsSewing(results[root - 1], m_sewingTolerance)) {
+                        m_partCallback(results[root - 1]);
+                    }
+                }
+            } catch (const Standard_Failure& e) {
+                qWarning() << "IgesReader::read() - 根实体" << root << "转换异常:" << e.GetMessageString();
+            }
+        }
+    }, nbWorkers == 1);
+    m_stats.transferMs = timer.restart();
+    if (!scope.More()) {
+        return false;
+    }
+
+    // 收集全部结果：壳和实体直接保留，散面进入缝合
+    BRep_Builder builder;
+    TopoDS_Compound compound;
+    builder.MakeCompound(compound);
+    TopoDS_Compound looseFaces;
+    builder.MakeCompound(looseFaces);
+    std::vector<TopoDS_Face> faces;
+    for (const TopoDS_Shape& result : results) {
+        if (result.IsNull()) {
+            continue;
+        }
+        ++m_stats.nbShapes;
+        if (!needsSewing(result, m_sewingTolerance)) {
+            builder.Add(compound, result);
+            continue;
+        }
+        for (TopExp_Explorer explorer(result, TopAbs_FACE); explorer.More(); explorer.Next()) {
+            faces.push_back(TopoDS::Face(explorer.Current()));
+            builder.Add(looseFaces, explorer.Current());
+        }
+    }
+    m_stats.nbFaces = int(faces.size());
+    if (m_stats.nbShapes == 0) {
+        qWarning() << "IgesReader::read() - 没有转换出任何形状:" << filename;
+        return false;
+    }
+
+    if (!faces.empty()) {
+        // 面修复：散面之间不共享边时各面互相独立，可以并行
+        TopTools_IndexedDataMapOfShapeListOfShape edgeFaces;
+        TopExp::MapShapesAndAncestors(looseFaces, TopAbs_EDGE, TopAbs_FACE, edgeFaces);
+        bool sharedEdges = false;
+        for (Standard_Integer i = 1; i <= edgeFaces.Extent() && !sharedEdges; ++i) {
+            sharedEdges = edgeFaces.FindFromIndex(i).Extent() > 1;
+        }
+        m_stats.parallelFix = !sharedEdges && m_threadCount > 1;
+
+        const double tolerance = m_sewingTolerance;
+        OSD_Parallel::For(0, int(faces.size()), [&faces, tolerance](int i) {
+            try {
+                ShapeFix_Face fixer(faces[i]);
+                fixer.SetPrecision(tolerance);
+                fixer.Perform();
+                faces[i] = fixer.Face();
+            } catch (const Standard_Failure& e) {
+                qWarning() << "IgesReader::read() - 面修复异常:" << e.GetMessageString();
+            }
+        }, !m_stats.parallelFix);
+        scope.Next();
+        m_stats.fixMs = timer.restart();
+
+        BRepBuilderAPI_Sewing sewing(m_sewingTolerance);
+        for (const TopoDS_Face& face : faces) {
+            sewing.Add(face);
+        }
+        sewing.Perform(scope.Next(3));
+        if (!scope.More()) {
+            return false;
+        }
+        m_stats.nbFreeEdges = sewing.NbFreeEdges();
+        const TopoDS_Shape sewn = sewing.SewedShape();
+        if (!sewn.IsNull()) {
+            builder.Add(compound, sewn);
+            if (m_partCallback) {
+                m_partCallback(sewn);
+            }
+        }
+        m_stats.sewMs = timer.restart();
+    }
+
+    // 只有一个子形状时去掉复合体层级
+    TopoDS_Iterator it(compound);
+    if (it.More()) {
+        TopoDS_Shape first = it.Value();
+        it.Next();
+        m_shape = it.More() ? TopoDS_Shape(compound) : first;
+    }
+
+    qDebug() << "IgesReader::read() -" << filename
+             << "根实体:" << m_stats.nbRoots << "形状:" << m_stats.nbShapes << "线程:" << m_stats.nbWorkers
+             << (m_stats.sharedEntities ? "(根实体共享几何，串行转换)" : "")
+             << "缝合面:" << m_stats.nbFaces << "自由边:" << m_stats.nbFreeEdges
+             << (m_stats.parallelFix ? "并行修复" : "串行修复");
+    qDebug() << "IgesReader::read() - 解析(ms):" << m_stats.readMs << "转换(ms):" << m_stats.transferMs
+             << "修复(ms):" << m_stats.fixMs << "缝合(ms):" << m_stats.sewMs;
+    return !m_shape.IsNull();
+}
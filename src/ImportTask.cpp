@@ -0,0 +1,46 @@
+﻿#include "ImportTask.h"
+#include <QDebug>
+
+ImportTask::ImportTask(const QStringList& filenames, const ImportOptions& options, bool streaming, QObject* parent)
+    : QThread(parent)
+    , m_filenames(filenames)
+    , m_options(options)
+    , m_streaming(streaming)
+    , m_progress(new ImportProgress())
+{
+    if (m_streaming) {
+        m_options.partCallback = [this](const QString& filename, const TopoDS_Shape& part) {
+            QMutexLocker locker(&m_partsMutex);
+            ImportPart item;
+            item.filename = filename;
+            item.index = ++m_partCounts[filename];
+            item.shape = part;
+            m_parts.append(item);
+        };
+    }
+}
+
+ImportTask::~ImportTask()
+{
+    // 窗口关闭时仍在转换：请求取消并等待线程退出
+    if (isRunning()) {
+        cancel();
+        wait();
+    }
+}
+
+QList<ImportPart> ImportTask::takeParts()
+{
+    QMutexLocker locker(&m_partsMutex);
+    QList<ImportPart> parts;
+    parts.swap(m_parts);
+    return parts;
+}
+
+void ImportTask::run()
+{
+    m_results = FileIO::importFiles(m_filenames, m_options, 0, m_progress->Start());
+    if (isCancelled()) {
+        qDebug() << "ImportTask::run() - 导入已取消";
+    }
+}
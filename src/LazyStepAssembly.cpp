@@ -0,0 +1,461 @@
+﻿#include "LazyStepAssembly.h"
+#include "StepParser.h"
+#include <STEPControl_Reader.hxx>
+#include <STEPConstruct_UnitContext.hxx>
+#include <StepData_StepModel.hxx>
+#include <StepBasic_ProductDefinition.hxx>
+#include <StepBasic_ProductDefinitionFormation.hxx>
+#include <StepBasic_Product.hxx>
+#include <StepRepr_NextAssemblyUsageOccurrence.hxx>
+#include <StepRepr_ProductDefinitionShape.hxx>
+#include <StepRepr_PropertyDefinition.hxx>
+#include <StepRepr_CharacterizedDefinition.hxx>
+#include <StepRepr_RepresentedDefinition.hxx>
+#include <StepRepr_Representation.hxx>
+#include <StepRepr_RepresentationContext.hxx>
+#include <StepRepr_GlobalUnitAssignedContext.hxx>
+#include <StepRepr_ShapeRepresentationRelationship.hxx>
+#include <StepRepr_RepresentationRelationshipWithTransformation.hxx>
+#include <StepRepr_ShapeRepresentationRelationshipWithTransformation.hxx>
+#include <StepRepr_Transformation.hxx>
+#include <StepRepr_ItemDefinedTransformation.hxx>
+#include <StepShape_ShapeDefinitionRepresentation.hxx>
+#include <StepShape_ContextDependentShapeRepresentation.hxx>
+#include <StepGeom_Axis2Placement3d.hxx>
+#include <StepGeom_CartesianPoint.hxx>
+#include <StepGeom_GeometricRepresentationContextAndGlobalUnitAssignedContext.hxx>
+#include <StepGeom_GeomRepContextAndGlobUnitAssCtxAndGlobUncertaintyAssCtx.hxx>
+#include <StepToGeom.hxx>
+#include <Geom_Axis2Placement.hxx>
+#include <XSControl_WorkSession.hxx>
+#include <Interface_Graph.hxx>
+#include <Interface_EntityIterator.hxx>
+#include <TCollection_HAsciiString.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Ax3.hxx>
+#include <Standard_Failure.hxx>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+// 装配层级上限，防止循环引用
+const int THE_MAX_DEPTH = 64;
+
+QString productName(const Handle(StepBasic_ProductDefinition)& definition, int index)
+{
+    if (!definition->Formation().IsNull() && !definition->Formation()->OfProduct().IsNull()) {
+        const Handle(StepBasic_Product)& product = definition->Formation()->OfProduct();
+        if (!product->Name().IsNull() && product->Name()->Length() > 0) {
+            return QString::fromUtf8(product->Name()->ToCString());
+        }
+        if (!product->Id().IsNull() && product->Id()->Length() > 0) {
+            return QString::fromUtf8(product->Id()->ToCString());
+        }
+    }
+    return QString("Part_%1").arg(index + 1);
+}
+
+// 表示的长度单位换算到会话单位的比例：按表示上下文的全局单位（毫米）除以会话单位，
+// 与 STEPControl_ActorRead 转换几何时的取法一致；同一上下文只计算一次
+class UnitScales
+{
+public:
+    explicit UnitScales(const Handle(StepData_StepModel)& model)
+        : m_sessionUnit(model->LocalLengthUnit() > 0.0 ? model->LocalLengthUnit() : 1.0)
+    {
+    }
+
+    double of(const Handle(StepRepr_Representation)& rep)
+    {
+        Handle(StepRepr_RepresentationContext) context;
+        if (!rep.IsNull()) {
+            context = rep->ContextOfItems();
+        }
+        auto it = m_scales.find(context.get());
+        if (it != m_scales.end()) {
+            return it->second;
+        }
+        const double scale = fileUnit(context) / m_sessionUnit;
+        m_scales.emplace(context.get(), scale);
+        return scale;
+    }
+
+private:
+    // 上下文中的长度单位（毫米），没有单位信息时按毫米处理
+    static double fileUnit(const Handle(StepRepr_RepresentationContext)& context)
+    {
+        Handle(StepRepr_GlobalUnitAssignedContext) units = Handle(StepRepr_GlobalUnitAssignedContext)::DownCast(context);
+        if (units.IsNull()) {
+            Handle(StepGeom_GeometricRepresentationContextAndGlobalUnitAssignedContext) complex =
+                Handle(StepGeom_GeometricRepresentationContextAndGlobalUnitAssignedContext)::DownCast(context);
+            if (!complex.IsNull()) {
+                units = complex->GlobalUnitAssignedContext();
+            }
+        }
+        if (units.IsNull()) {
+            Handle(StepGeom_GeomRepContextAndGlobUnitAssCtxAndGlobUncertaintyAssCtx) complex =
+                Handle(StepGeom_GeomRepContextAndGlobUnitAssCtxAndGlobUncertaintyAssCtx)::DownCast(context);
+            if (!complex.IsNull()) {
+                units = complex->GlobalUnitAssignedContext();
+            }
+        }
+        if (units.IsNull()) {
+            return 1.0;
+        }
+        STEPConstruct_UnitContext unitContext;
+        unitContext.ComputeFactors(units);
+        return unitContext.LengthFactor() > 0.0 ? unitContext.LengthFactor() : 1.0;
+    }
+
+    double m_sessionUnit;
+    std::unordered_map<const Standard_Transient*, double> m_scales;
+};
+
+// NAUO 对应的实例变换（子零件坐标系 -> 父装配坐标系），与 STEPControl_ActorRead 的约定一致；
+// 平移部分按父装配表示的单位换算到会话单位
+bool instanceTransformation(const Handle(StepShape_ContextDependentShapeRepresentation)& cdsr,
+                            const std::unordered_map<const Standard_Transient*, int>& repOwner,
+                            int childIndex, UnitScales& unitScales, gp_Trsf& trsf)
+{
+    Handle(StepRepr_RepresentationRelationshipWithTransformation) relation =
+        Handle(StepRepr_RepresentationRelationshipWithTransformation)::DownCast(cdsr->RepresentationRelation());
+    if (relation.IsNull()) {
+        return false;
+    }
+    Handle(StepRepr_ItemDefinedTransformation) transformation =
+        relation->TransformationOperator().ItemDefinedTransformation();
+    if (transformation.IsNull()) {
+        return false;
+    }
+    Handle(StepGeom_Axis2Placement3d) origin = Handle(StepGeom_Axis2Placement3d)::DownCast(transformation->TransformItem1());
+    Handle(StepGeom_Axis2Placement3d) target = Handle(StepGeom_Axis2Placement3d)::DownCast(transformation->TransformItem2());
+    if (origin.IsNull() || target.IsNull()) {
+        return false;
+    }
+    Handle(Geom_Axis2Placement) originAxis = StepToGeom::MakeAxis2Placement(origin);
+    Handle(Geom_Axis2Placement) targetAxis = StepToGeom::MakeAxis2Placement(target);
+    if (originAxis.IsNull() || targetAxis.IsNull()) {
+        return false;
+    }
+    trsf.SetTransformation(gp_Ax3(targetAxis->Ax2()), gp_Ax3(originAxis->Ax2()));
+
+    // 部分文件中 rep_2 才是子零件的表示，此时变换方向相反
+    auto owner = [&repOwner](const Handle(StepRepr_Representation)& rep) {
+        auto it = repOwner.find(rep.get());
+        return it != repOwner.end() ? it->second : -1;
+    };
+    const bool inverted = owner(relation->Rep2()) == childIndex && owner(relation->Rep1()) != childIndex;
+    const double scale = unitScales.of(inverted ? relation->Rep1() : relation->Rep2());
+    trsf.SetTranslationPart(trsf.TranslationPart() * scale);
+    if (inverted) {
+        trsf.Invert();
+    }
+    return true;
+}
+
+} // namespace
+
+LazyStepAssembly::LazyStepAssembly()
+{
+}
+
+LazyStepAssembly::~LazyStepAssembly()
+{
+}
+
+bool LazyStepAssembly::open(const QString& filename)
+{
+    m_filename = filename;
+    m_parts.clear();
+    m_instances.clear();
+    m_placeholders.clear();
+    m_stats = Statistics();
+
+    QElapsedTimer timer;
+    timer.start();
+    m_reader.reset(new STEPControl_Reader());
+    StepParser parser;
+    bool loaded = parser.read(filename, *m_reader);
+    if (!loaded) {
+        qWarning() << "LazyStepAssembly::open() - 并行解析失败，改用标准解析:" << filename;
+        loaded = m_reader->ReadFile(filename.toStdString().c_str()) == IFSelect_RetDone;
+    }
+    if (!loaded) {
+        qWarning() << "LazyStepAssembly::open() - 无法解析文件:" << filename;
+        m_reader.reset();
+        return false;
+    }
+    m_stats.parseMs = timer.restart();
+
+    // 一次遍历收集装配结构相关的实体
+    Handle(StepData_StepModel) model = m_reader->StepModel();
+    std::vector<Handle(StepBasic_ProductDefinition)> definitions;
+    std::vector<Handle(StepRepr_NextAssemblyUsageOccurrence)> usages;
+    std::vector<Handle(StepShape_ShapeDefinitionRepresentation)> shapeDefinitions;
+    std::vector<Handle(StepShape_ContextDependentShapeRepresentation)> placements;
+    std::vector<Handle(StepRepr_ShapeRepresentationRelationship)> repRelations;
+    std::unordered_map<const Standard_Transient*, int> definitionIndex;
+    const Standard_Integer nbEntities = model->NbEntities();
+    for (Standard_Integer i = 1; i <= nbEntities; ++i) {
+        const Handle(Standard_Transient)& entity = model->Value(i);
+        if (entity->IsKind(STANDARD_TYPE(StepBasic_ProductDefinition))) {
+            definitionIndex[entity.get()] = int(definitions.size());
+            definitions.push_back(Handle(StepBasic_ProductDefinition)::DownCast(entity));
+        } else if (entity->IsKind(STANDARD_TYPE(StepRepr_NextAssemblyUsageOccurrence))) {
+            usages.push_back(Handle(StepRepr_NextAssemblyUsageOccurrence)::DownCast(entity));
+        } else if (entity->IsKind(STANDARD_TYPE(StepShape_ShapeDefinitionRepresentation))) {
+            shapeDefinitions.push_back(Handle(StepShape_ShapeDefinitionRepresentation)::DownCast(entity));
+        } else if (entity->IsKind(STANDARD_TYPE(StepShape_ContextDependentShapeRepresentation))) {
+            placements.push_back(Handle(StepShape_ContextDependentShapeRepresentation)::DownCast(entity));
+        } else if (entity->IsKind(STANDARD_TYPE(StepRepr_ShapeRepresentationRelationship))
+                   && !entity->IsKind(STANDARD_TYPE(StepRepr_ShapeRepresentationRelationshipWithTransformation))) {
+            repRelations.push_back(Handle(StepRepr_ShapeRepresentationRelationship)::DownCast(entity));
+        }
+    }
+    const int nbDefinitions = int(definitions.size());
+    m_stats.nbProducts = nbDefinitions;
+    if (nbDefinitions == 0) {
+        qWarning() << "LazyStepAssembly::open() - 文件中没有产品定义:" << filename;
+        return false;
+    }
+
+    auto indexOf = [&definitionIndex](const Handle(Standard_Transient)& entity) {
+        auto it = definitionIndex.find(entity.get());
+        return it != definitionIndex.end() ? it->second : -1;
+    };
+
+    // 产品定义 -> 形状表示（含通过非变换关系关联的表示，如 advanced_brep_shape_representation）
+    std::vector<std::vector<Handle(StepRepr_Representation)>> reps(nbDefinitions);
+    std::unordered_map<const Standard_Transient*, int> repOwner;
+    for (const Handle(StepShape_ShapeDefinitionRepresentation)& sdr : shapeDefinitions) {
+        Handle(StepRepr_PropertyDefinition) property = sdr->Definition().PropertyDefinition();
+        if (property.IsNull() || sdr->UsedRepresentation().IsNull()) {
+            continue;
+        }
+        const int owner = indexOf(property->Definition().ProductDefinition());
+        if (owner >= 0) {
+            reps[owner].push_back(sdr->UsedRepresentation());
+            repOwner[sdr->UsedRepresentation().get()] = owner;
+        }
+    }
+    for (const Handle(StepRepr_ShapeRepresentationRelationship)& relation : repRelations) {
+        auto owner1 = repOwner.find(relation->Rep1().get());
+        auto owner2 = repOwner.find(relation->Rep2().get());
+        if (owner1 != repOwner.end() && owner2 == repOwner.end() && !relation->Rep2().IsNull()) {
+            reps[owner1->second].push_back(relation->Rep2());
+        } else if (owner2 != repOwner.end() && owner1 == repOwner.end() && !relation->Rep1().IsNull()) {
+            reps[owner2->second].push_back(relation->Rep1());
+        }
+    }
+
+    // 实例变换
+    UnitScales unitScales(model);
+    std::unordered_map<const Standard_Transient*, gp_Trsf> usageTrsf;
+    for (const Handle(StepShape_ContextDependentShapeRepresentation)& cdsr : placements) {
+        if (cdsr->RepresentedProductRelation().IsNull()) {
+            continue;
+        }
+        Handle(StepRepr_NextAssemblyUsageOccurrence) usage = Handle(StepRepr_NextAssemblyUsageOccurrence)::DownCast(
+            cdsr->RepresentedProductRelation()->Definition().ProductDefinitionRelationship());
+        if (usage.IsNull()) {
+            continue;
+        }
+        gp_Trsf trsf;
+        try {
+            if (instanceTransformation(cdsr, repOwner, indexOf(usage->RelatedProductDefinition()), unitScales, trsf)) {
+                usageTrsf[usage.get()] = trsf;
+            }
+        } catch (const Standard_Failure& e) {
+            qWarning() << "LazyStepAssembly::open() - 实例变换无效:" << e.GetMessageString();
+        }
+    }
+
+    // 装配树
+    std::vector<std::vector<std::pair<int, gp_Trsf>>> children(nbDefinitions);
+    std::vector<bool> isChild(nbDefinitions, false);
+    for (const Handle(StepRepr_NextAssemblyUsageOccurrence)& usage : usages) {
+        const int parent = indexOf(usage->RelatingProductDefinition());
+        const int child = indexOf(usage->RelatedProductDefinition());
+        if (parent < 0 || child < 0 || parent == child) {
+            continue;
+        }
+        auto it = usageTrsf.find(usage.get());
+        children[parent].emplace_back(child, it != usageTrsf.end() ? it->second : gp_Trsf());
+        isChild[child] = true;
+    }
+
+    // 叶子产品定义为零件
+    std::vector<int> partOf(nbDefinitions, -1);
+    for (int i = 0; i < nbDefinitions; ++i) {
+        if (children[i].empty()) {
+            partOf[i] = int(m_parts.size());
+            Part part;
+            part.name = productName(definitions[i], i);
+            part.definition = definitions[i];
+            m_parts.push_back(part);
+        }
+    }
+
+    // 从根装配展开实例
+    struct Node
+    {
+        int definition;
+        gp_Trsf trsf;
+        QString path;
+        int depth;
+    };
+    std::vector<Node> stack;
+    for (int i = nbDefinitions - 1; i >= 0; --i) {
+        if (!isChild[i]) {
+            stack.push_back({ i, gp_Trsf(), productName(definitions[i], i), 0 });
+        }
+    }
+    while (!stack.empty()) {
+        Node node = stack.back();
+        stack.pop_back();
+        if (partOf[node.definition] >= 0) {
+            Instance instance;
+            instance.part = partOf[node.definition];
+            instance.name = node.path;
+            instance.trsf = node.trsf;
+            m_instances.push_back(instance);
+            continue;
+        }
+        if (node.depth >= THE_MAX_DEPTH) {
+            qWarning() << "LazyStepAssembly::open() - 装配层级过深，已截断:" << node.path;
+            continue;
+        }
+        const std::vector<std::pair<int, gp_Trsf>>& nodeChildren = children[node.definition];
+        for (auto it = nodeChildren.rbegin(); it != nodeChildren.rend(); ++it) {
+            stack.push_back({ it->first, node.trsf.Multiplied(it->second),
+                              node.path + "/" + productName(definitions[it->first], it->first), node.depth + 1 });
+        }
+    }
+    m_stats.structureMs = timer.restart();
+
+    // 包围盒：沿实体引用关系收集零件表示中的所有控制点，不做几何转换，坐标换算到会话单位
+    const Interface_Graph& graph = m_reader->WS()->Graph();
+    for (int i = 0; i < nbDefinitions; ++i) {
+        if (partOf[i] < 0) {
+            continue;
+        }
+        Bnd_Box& box = m_parts[partOf[i]].box;
+        const double scale = unitScales.of(reps[i].empty() ? Handle(StepRepr_Representation)() : reps[i].front());
+        std::unordered_set<const Standard_Transient*> visited;
+        std::vector<Handle(Standard_Transient)> pending(reps[i].begin(), reps[i].end());
+        while (!pending.empty()) {
+            Handle(Standard_Transient) entity = pending.back();
+            pending.pop_back();
+            if (entity.IsNull() || !visited.insert(entity.get()).second) {
+                continue;
+            }
+            Handle(StepGeom_CartesianPoint) point = Handle(StepGeom_CartesianPoint)::DownCast(entity);
+            if (!point.IsNull()) {
+                if (point->NbCoordinates() == 3) {
+                    box.Add(gp_Pnt(point->CoordinatesValue(1) * scale, point->CoordinatesValue(2) * scale,
+                                   point->CoordinatesValue(3) * scale));
+                }
+                continue;
+            }
+            Interface_EntityIterator shareds = graph.Shareds(entity);
+            for (shareds.Start(); shareds.More(); shareds.Next()) {
+                pending.push_back(shareds.Value());
+            }
+        }
+    }
+
+    // 每个零件一个占位长方体，实例共享
+    m_placeholders.resize(m_parts.size());
+    for (size_t i = 0; i < m_parts.size(); ++i) {
+        const Bnd_Box& box = m_parts[i].box;
+        if (box.IsVoid()) {
+            continue;
+        }
+        Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+        box.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+        // 平面零件的包围盒可能退化，按对角线放大一点
+        const Standard_Real gap = std::max(1.0e-3, 1.0e-3 * std::sqrt(box.SquareExtent()));
+        xMax = std::max(xMax, xMin + gap);
+        yMax = std::max(yMax, yMin + gap);
+        zMax = std::max(zMax, zMin + gap);
+        try {
+            m_placeholders[i] = BRepPrimAPI_MakeBox(gp_Pnt(xMin, yMin, zMin), gp_Pnt(xMax, yMax, zMax)).Shape();
+        } catch (const Standard_Failure& e) {
+            qWarning() << "LazyStepAssembly::open() - 无法生成占位形状:" << m_parts[i].name << e.GetMessageString();
+        }
+    }
+    m_stats.boxMs = timer.elapsed();
+    m_stats.nbParts = partCount();
+    m_stats.nbInstances = instanceCount();
+
+    qDebug() << "LazyStepAssembly::open() -" << filename
+             << "产品:" << m_stats.nbProducts << "零件:" << m_stats.nbParts << "实例:" << m_stats.nbInstances
+             << "解析(ms):" << m_stats.parseMs << "结构(ms):" << m_stats.structureMs << "包围盒(ms):" << m_stats.boxMs;
+    return !m_instances.empty();
+}
+
+TopoDS_Shape LazyStepAssembly::placeholder(int instance) const
+{
+    if (instance < 0 || instance >= instanceCount()) {
+        return TopoDS_Shape();
+    }
+    const Instance& item = m_instances[instance];
+    const TopoDS_Shape& box = m_placeholders[item.part];
+    if (box.IsNull()) {
+        return TopoDS_Shape();
+    }
+    return box.Moved(TopLoc_Location(item.trsf));
+}
+
+TopoDS_Shape LazyStepAssembly::loadInstance(int instance)
+{
+    if (instance < 0 || instance >= instanceCount()) {
+        return TopoDS_Shape();
+    }
+    const Instance& item = m_instances[instance];
+    if (!m_parts[item.part].loaded) {
+        loadPart(item.part);
+    }
+    const TopoDS_Shape& shape = m_parts[item.part].shape;
+    if (shape.IsNull()) {
+        return TopoDS_Shape();
+    }
+    return shape.Moved(TopLoc_Location(item.trsf));
+}
+
+bool LazyStepAssembly::loadPart(int index)
+{
+    Part& part = m_parts[index];
+    part.loaded = true;
+    if (!m_reader) {
+        return false;
+    }
+
+    // 只转换该零件的产品定义，结果位于零件自身坐标系
+    QElapsedTimer timer;
+    timer.start();
+    const Standard_Integer nbBefore = m_reader->NbShapes();
+    try {
+        m_reader->TransferEntity(part.definition);
+        if (m_reader->NbShapes() > nbBefore) {
+            part.shape = m_reader->Shape(m_reader->NbShapes());
+        }
+    } catch (const Standard_Failure& e) {
+        qWarning() << "LazyStepAssembly::loadPart() - 转换异常:" << part.name << e.GetMessageString();
+    }
+    const qint64 elapsed = timer.elapsed();
+    m_stats.transferMs += elapsed;
+    ++m_stats.nbLoadedParts;
+
+    qDebug() << "LazyStepAssembly::loadPart() -" << part.name << "耗时(ms):" << elapsed
+             << "已加载:" << m_stats.nbLoadedParts << "/" << m_stats.nbParts
+             << (part.shape.IsNull() ? "(无几何)" : "");
+    return !part.shape.IsNull();
+}
@@ -6,6 +6,8 @@
 #include "Modeling.h"
 #include "TransformManager.h"
 #include "ParameterDialog.h"
+#include "ImportTask.h"
+#include "LazyStepAssembly.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QInputDialog>
@@ -15,7 +17,16 @@
 #include <QToolBar>
 #include <QTimer>
 #include <QDebug>
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QFile>
+#include <QDragEnterEvent>
+#include <QDropEvent>
+#include <QMimeData>
+#include <QUrl>
 #include <TopoDS_Shape.hxx>
+#include <TopoDS_Compound.hxx>
+#include <BRep_Builder.hxx>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -24,6 +35,16 @@ MainWindow::MainWindow(QWidget *parent)
     , m_selectionManager(nullptr)
     , m_selectionFilterCombo(nullptr)
     , m_statusLabel(nullptr)
+    , m_importProgressBar(nullptr)
+    , m_cancelImportButton(nullptr)
+    , m_importTimer(nullptr)
+    , m_importTask(nullptr)
+    , m_streamImportAction(nullptr)
+    , m_stepParallelParseAction(nullptr)
+    , m_streamedParts(0)
+    , m_autosaveTimer(nullptr)
+    , m_restoreTimer(nullptr)
+    , m_restoreNext(0)
 {
     // 创建核心对象
     m_document = new Document(this);
@@ -41,10 +62,23 @@ MainWindow::MainWindow(QWidget *parent)
     
     setWindowTitle("MyCad - 3D CAD Software");
     resize(1200, 800);
+    setAcceptDrops(true);
 }
 
 MainWindow::~MainWindow()
 {
+    // 取消并等待未完成的导入，结果直接丢弃
+    if (m_importTask) {
+        disconnect(m_importTask, nullptr, this, nullptr);
+        delete m_importTask;
+        m_importTask = nullptr;
+    }
+    
+    // 正常退出时不再需要自动保存的文件（先等后台自动保存结束）
+    disconnect(m_document, nullptr, this, nullptr);
+    delete m_document;
+    m_document = nullptr;
+    QFile::remove(autosavePath());
 }
 
 void MainWindow::setupUI()
@@ -56,6 +90,32 @@ void MainWindow::setupUI()
     
     m_statusLabel = new QLabel("就绪", this);
     statusBar()->addWidget(m_statusLabel);
+    
+    // 导入进度条和取消按钮，只在后台导入时显示
+    m_importProgressBar = new QProgressBar(this);
+    m_importProgressBar->setRange(0, 100);
+    m_importProgressBar->setMaximumWidth(200);
+    m_importProgressBar->hide();
+    statusBar()->addPermanentWidget(m_importProgressBar);
+    
+    m_cancelImportButton = new QPushButton("取消", this);
+    m_cancelImportButton->hide();
+    statusBar()->addPermanentWidget(m_cancelImportButton);
+    connect(m_cancelImportButton, &QPushButton::clicked, this, &MainWindow::onCancelImport);
+    
+    m_importTimer = new QTimer(this);
+    m_importTimer->setInterval(100);
+    connect(m_importTimer, &QTimer::timeout, this, &MainWindow::onImportProgress);
+    
+    m_autosaveTimer = new QTimer(this);
+    m_autosaveTimer->setInterval(5 * 60 * 1000);
+    connect(m_autosaveTimer, &QTimer::timeout, this, &MainWindow::onAutosave);
+    m_autosaveTimer->start();
+    
+    // 间隔为0：每处理完一次界面事件恢复一批，视图在恢复期间保持可交互
+    m_restoreTimer = new QTimer(this);
+    m_restoreTimer->setInterval(0);
+    connect(m_restoreTimer, &QTimer::timeout, this, &MainWindow::onRestoreShapes);
 }
 
 void MainWindow::setupMenus()
@@ -74,12 +134,27 @@ void MainWindow::setupMenus()
     QAction* importAction = fileMenu->addAction("导入(&I)");
     connect(importAction, &QAction::triggered, this, &MainWindow::onImportFile);
     
+    QAction* importLazyAction = fileMenu->addAction("导入STEP装配(延迟加载)...");
+    connect(importLazyAction, &QAction::triggered, this, &MainWindow::onImportStepLazy);
+    
+    m_streamImportAction = fileMenu->addAction("导入时逐个显示部件");
+    m_streamImportAction->setCheckable(true);
+    m_streamImportAction->setChecked(true);
+    
+    m_stepParallelParseAction = fileMenu->addAction("大型STEP文件并行解析");
+    m_stepParallelParseAction->setCheckable(true);
+    m_stepParallelParseAction->setChecked(true);
+    
     fileMenu->addSeparator();
     
     QAction* saveAction = fileMenu->addAction("保存(&S)");
     saveAction->setShortcut(QKeySequence::Save);
     connect(saveAction, &QAction::triggered, this, &MainWindow::onSaveFile);
     
+    QAction* saveAsAction = fileMenu->addAction("另存为(&A)...");
+    saveAsAction->setShortcut(QKeySequence::SaveAs);
+    connect(saveAsAction, &QAction::triggered, this, &MainWindow::onSaveFileAs);
+    
     QAction* exportAction = fileMenu->addAction("导出(&E)");
     connect(exportAction, &QAction::triggered, this, &MainWindow::onExportFile);
     
@@ -218,10 +293,14 @@ void MainWindow::connectSignals()
 {
     connect(m_selectionFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onSelectionFilterChanged);
+    connect(m_view3D, &View3D::selectionChanged, this, &MainWindow::onViewSelectionChanged);
+    connect(m_document, &Document::autosaveFinished, this, &MainWindow::onAutosaveFinished);
 }
 
 void MainWindow::onNewFile()
 {
+    m_restoreTimer->stop();
+    m_lazyInstances.clear();
     m_document->clear();
     m_view3D->fitAll();
     m_statusLabel->setText("新建文件");
@@ -232,8 +311,18 @@ void MainWindow::onOpenFile()
     QString filename = QFileDialog::getOpenFileName(this, "打开文件", "", 
                                                     "MyCad文件 (*.mycad);;所有文件 (*.*)");
     if (!filename.isEmpty()) {
+        m_restoreTimer->stop();
+        m_lazyInstances.clear();
         if (m_document->loadFromFile(filename)) {
-            m_statusLabel->setText(QString("已打开: %1").arg(filename));
+            // 先显示包围盒占位，几何在后台分批恢复；选中或导出的形状仍会立即恢复
+            const int nbPending = m_document->pendingCount();
+            if (nbPending > 0) {
+                m_restoreNext = 0;
+                m_restoreTimer->start();
+            }
+            m_statusLabel->setText(nbPending > 0
+                ? QString("已打开: %1（正在恢复 %2 个形状）").arg(filename).arg(nbPending)
+                : QString("已打开: %1").arg(filename));
         } else {
             QMessageBox::warning(this, "错误", "无法打开文件");
         }
@@ -243,18 +332,362 @@ void MainWindow::onOpenFile()
 void MainWindow::onImportFile()
 {
     QString filter = FileIO::getFileFilter(true);
-    QString filename = QFileDialog::getOpenFileName(this, "导入文件", "", filter);
+    QStringList filenames = QFileDialog::getOpenFileNames(this, "导入文件", "", filter);
     
-    if (!filename.isEmpty()) {
-        TopoDS_Shape shape;
-        if (FileIO::importFile(filename, shape)) {
-            m_document->addShape(shape, QFileInfo(filename).baseName());
+    if (!filenames.isEmpty()) {
+        importFiles(filenames);
+    }
+}
+
+void MainWindow::importFiles(const QStringList& filenames)
+{
+    if (m_importTask) {
+        QMessageBox::information(this, "提示", "正在导入其他文件，请等待完成或取消后再试");
+        return;
+    }
+    
+    // 转换在后台线程进行，GUI线程只定时刷新进度，视图保持可交互
+    ImportOptions options;
+    options.stepParallelParse = m_stepParallelParseAction->isChecked();
+    m_importTask = new ImportTask(filenames, options, m_streamImportAction->isChecked(), this);
+    m_streamedParts = 0;
+    connect(m_importTask, &QThread::finished, this, &MainWindow::onImportFinished);
+    
+    m_statusLabel->setText(QString("正在导入 %1 个文件...").arg(filenames.size()));
+    m_importProgressBar->setValue(0);
+    m_importProgressBar->show();
+    m_cancelImportButton->setEnabled(true);
+    m_cancelImportButton->show();
+    m_importTimer->start();
+    m_importTask->start();
+}
+
+void MainWindow::onImportProgress()
+{
+    if (m_importTask) {
+        m_importProgressBar->setValue(m_importTask->progress());
+        // 已完成的部件随进度一起按定时器节奏显示，每次最多重绘一次
+        if (m_importTask->isStreaming() && addStreamedParts(m_importTask) > 0) {
+            m_statusLabel->setText(QString("正在导入，已显示 %1 个部件...").arg(m_streamedParts));
+        }
+    }
+}
+
+int MainWindow::addStreamedParts(ImportTask* task)
+{
+    const QList<ImportPart> parts = task->takeParts();
+    if (parts.isEmpty()) {
+        return 0;
+    }
+    
+    QList<TopoDS_Shape> shapes;
+    QStringList names;
+    for (const ImportPart& part : parts) {
+        shapes.append(part.shape);
+        names.append(QString("%1#%2").arg(QFileInfo(part.filename).baseName()).arg(part.index));
+    }
+    const bool first = m_streamedParts == 0;
+    m_document->addShapes(shapes, names);
+    m_streamedParts += parts.size();
+    
+    // 第一批部件出现时调整视图，之后保持用户当前的视角
+    if (first) {
+        m_view3D->fitAll();
+    }
+    return parts.size();
+}
+
+void MainWindow::onCancelImport()
+{
+    if (m_importTask) {
+        m_importTask->cancel();
+        m_cancelImportButton->setEnabled(false);
+        m_statusLabel->setText("正在取消导入...");
+    }
+}
+
+void MainWindow::onImportFinished()
+{
+    ImportTask* task = m_importTask;
+    m_importTask = nullptr;
+    m_importTimer->stop();
+    m_importProgressBar->hide();
+    m_cancelImportButton->hide();
+    if (task == nullptr) {
+        return;
+    }
+    task->deleteLater();
+    
+    // 流式模式下部件已逐个加入文档，这里只补上队列中剩余的部件
+    const bool streaming = task->isStreaming();
+    if (streaming) {
+        addStreamedParts(task);
+    }
+    
+    if (task->isCancelled()) {
+        if (streaming && m_streamedParts > 0) {
+            m_statusLabel->setText(QString("导入已取消，保留已显示的 %1 个部件").arg(m_streamedParts));
+        } else {
+            m_statusLabel->setText("导入已取消");
+        }
+        return;
+    }
+    
+    // 非流式模式下所有文件转换完成后在GUI线程一次性加入文档
+    const QStringList& filenames = task->filenames();
+    const QList<ImportResult>& results = task->results();
+    QList<TopoDS_Shape> shapes;
+    QStringList names;
+    QStringList failed;
+    for (const ImportResult& result : results) {
+        if (result.success) {
+            shapes.append(result.shape);
+            names.append(QFileInfo(result.filename).baseName());
+        } else {
+            failed.append(QFileInfo(result.filename).fileName());
+        }
+    }
+    if (!streaming) {
+        m_document->addShapes(shapes, names);
+        if (!shapes.isEmpty()) {
             m_view3D->fitAll();
-            m_statusLabel->setText(QString("已导入: %1").arg(filename));
+        }
+    }
+    if (filenames.size() == 1 && shapes.size() == 1) {
+        m_statusLabel->setText(QString("已导入: %1").arg(filenames.first()));
+    } else {
+        m_statusLabel->setText(QString("已导入 %1 个文件，失败 %2 个").arg(shapes.size()).arg(failed.size()));
+    }
+    if (!failed.isEmpty()) {
+        QMessageBox::warning(this, "错误", QString("无法导入文件:\n%1").arg(failed.join("\n")));
+    }
+}
+
+void MainWindow::onImportStepLazy()
+{
+    QString filename = QFileDialog::getOpenFileName(this, "导入STEP装配", "", "STEP (*.step *.stp)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    // 只建立装配结构，每个零件实例先以包围盒线框占位
+    m_statusLabel->setText(QString("正在读取装配结构: %1").arg(filename));
+    std::shared_ptr<LazyStepAssembly> assembly = std::make_shared<LazyStepAssembly>();
+    if (!assembly->open(filename)) {
+        QMessageBox::warning(this, "错误", "无法读取STEP装配结构");
+        m_statusLabel->setText("就绪");
+        return;
+    }
+    
+    const QString baseName = QFileInfo(filename).baseName();
+    QList<TopoDS_Shape> shapes;
+    QStringList names;
+    QList<LazyInstance> instances;
+    for (int i = 0; i < assembly->instanceCount(); ++i) {
+        TopoDS_Shape placeholder = assembly->placeholder(i);
+        if (placeholder.IsNull()) {
+            continue;
+        }
+        const QString name = QString("%1#%2 %3").arg(baseName).arg(i + 1)
+                                                .arg(assembly->part(assembly->instance(i).part).name);
+        LazyInstance lazy;
+        lazy.assembly = assembly;
+        lazy.instance = i;
+        lazy.placeholder = placeholder;
+        instances.append(lazy);
+        shapes.append(placeholder);
+        names.append(name);
+    }
+    
+    // 名称可能与之前导入的同名文件重复，按文档分配的稳定ID记录占位对象
+    const int first = m_document->getShapeCount();
+    m_document->addShapes(shapes, names);
+    for (int i = 0; i < instances.size(); ++i) {
+        m_lazyInstances.insert(m_document->getShapeId(first + i), instances.at(i));
+    }
+    Handle(AIS_InteractiveContext) context = m_view3D->getContext();
+    if (!context.IsNull()) {
+        for (int i = first; i < m_document->getShapeCount(); ++i) {
+            Handle(AIS_InteractiveObject) object = m_document->getDisplayObject(i);
+            if (!object.IsNull()) {
+                context->SetDisplayMode(object, AIS_WireFrame, Standard_False);
+            }
+        }
+        context->UpdateCurrentViewer();
+    }
+    m_view3D->fitAll();
+    
+    const LazyStepAssembly::Statistics& stats = assembly->statistics();
+    m_statusLabel->setText(QString("已读取装配结构: %1 个零件, %2 个实例（选中后加载几何）")
+                               .arg(stats.nbParts).arg(shapes.size()));
+}
+
+void MainWindow::onViewSelectionChanged()
+{
+    // 打开的 .mycad 文档中选中的形状在此时恢复几何
+    if (m_document->pendingCount() > 0) {
+        QList<int> unloaded;
+        for (const auto& obj : m_selectionManager->getSelectedObjects()) {
+            int index = m_document->findObjectIndex(obj);
+            if (index >= 0 && !m_document->isLoaded(index)) {
+                unloaded.append(index);
+            }
+        }
+        if (!unloaded.isEmpty()) {
+            setCursor(Qt::WaitCursor);
+            m_document->loadShapes(unloaded);
+            unsetCursor();
+            m_statusLabel->setText(QString("已加载 %1 个形状，剩余 %2 个未加载")
+                                       .arg(unloaded.size()).arg(m_document->pendingCount()));
+        }
+    }
+    
+    if (m_lazyInstances.isEmpty()) {
+        return;
+    }
+    
+    // 选中的占位对象转换为实际几何
+    QList<int> selected;
+    for (const auto& obj : m_selectionManager->getSelectedObjects()) {
+        int index = m_document->findObjectIndex(obj);
+        if (index >= 0) {
+            selected.append(index);
+        }
+    }
+    int nbLoaded = 0;
+    loadLazyInstances(selected, nbLoaded);
+    if (nbLoaded > 0) {
+        m_statusLabel->setText(QString("已加载 %1 个零件实例，剩余 %2 个未加载").arg(nbLoaded).arg(m_lazyInstances.size()));
+    }
+}
+
+void MainWindow::onRestoreShapes()
+{
+    // 一批的数量：单批恢复时间保持在几十毫秒内，批内仍并行恢复
+    const int batchSize = 64;
+    QList<int> batch;
+    const int count = m_document->getShapeCount();
+    while (m_restoreNext < count && batch.size() < batchSize) {
+        if (!m_document->isLoaded(m_restoreNext)) {
+            batch.append(m_restoreNext);
+        }
+        ++m_restoreNext;
+    }
+    if (!batch.isEmpty()) {
+        m_document->loadShapes(batch);
+    }
+    // 恢复失败的形状保留占位，不再重试，避免反复触发
+    if (m_restoreNext >= count) {
+        m_restoreTimer->stop();
+        const int nbPending = m_document->pendingCount();
+        m_statusLabel->setText(nbPending > 0
+            ? QString("几何恢复完成，%1 个形状未恢复（选中时重试）").arg(nbPending)
+            : QString("几何恢复完成"));
+    }
+}
+
+bool MainWindow::loadLazyInstances(const QList<int>& indices, int& nbLoaded)
+{
+    nbLoaded = 0;
+    if (m_lazyInstances.isEmpty()) {
+        return true;
+    }
+    
+    QList<int> pending;
+    for (int index : indices) {
+        auto it = m_lazyInstances.find(m_document->getShapeId(index));
+        if (it == m_lazyInstances.end()) {
+            continue;
+        }
+        // 文档中的对象已被替换时不再加载
+        if (!m_document->getShape(index).IsPartner(it->placeholder)) {
+            m_lazyInstances.erase(it);
+            continue;
+        }
+        pending.append(index);
+    }
+    if (pending.isEmpty()) {
+        return true;
+    }
+    
+    // 替换不改变序号和ID，所有实例转换完后只刷新一次视图
+    setCursor(Qt::WaitCursor);
+    m_document->beginUpdate();
+    for (int index : pending) {
+        const quint64 id = m_document->getShapeId(index);
+        const LazyInstance lazy = m_lazyInstances.value(id);
+        TopoDS_Shape shape = lazy.assembly->loadInstance(lazy.instance);
+        if (!shape.IsNull()) {
+            m_document->replaceShape(index, shape);
+            m_lazyInstances.remove(id);
+            ++nbLoaded;
+        }
+    }
+    m_document->endUpdate();
+    unsetCursor();
+    return nbLoaded == pending.size();
+}
+
+bool MainWindow::resolveLazyInstances(const QList<int>& indices)
+{
+    int nbLoaded = 0;
+    if (loadLazyInstances(indices, nbLoaded)) {
+        return true;
+    }
+    QMessageBox::warning(this, "错误", "部分零件实例无法转换几何，仍为包围盒占位。\n请删除这些对象后再保存或导出。");
+    return false;
+}
+
+bool MainWindow::hasLazyPlaceholders()
+{
+    // 清理已删除或已被替换的占位对象
+    for (auto it = m_lazyInstances.begin(); it != m_lazyInstances.end();) {
+        const int index = m_document->findIndexById(it.key());
+        if (index < 0 || !m_document->getShape(index).IsPartner(it->placeholder)) {
+            it = m_lazyInstances.erase(it);
         } else {
-            QMessageBox::warning(this, "错误", "无法导入文件");
+            ++it;
+        }
+    }
+    return !m_lazyInstances.isEmpty();
+}
+
+QList<int> MainWindow::allShapeIndices() const
+{
+    QList<int> indices;
+    for (int i = 0; i < m_document->getShapeCount(); ++i) {
+        indices.append(i);
+    }
+    return indices;
+}
+
+void MainWindow::dragEnterEvent(QDragEnterEvent* event)
+{
+    if (event->mimeData()->hasUrls()) {
+        for (const QUrl& url : event->mimeData()->urls()) {
+            if (url.isLocalFile() && FileIO::canImport(url.toLocalFile())) {
+                event->acceptProposedAction();
+                return;
+            }
         }
     }
+    event->ignore();
+}
+
+void MainWindow::dropEvent(QDropEvent* event)
+{
+    QStringList filenames;
+    for (const QUrl& url : event->mimeData()->urls()) {
+        if (url.isLocalFile() && FileIO::canImport(url.toLocalFile())) {
+            filenames.append(url.toLocalFile());
+        }
+    }
+    if (filenames.isEmpty()) {
+        event->ignore();
+        return;
+    }
+    event->acceptProposedAction();
+    importFiles(filenames);
 }
 
 void MainWindow::onExportFile()
@@ -268,10 +701,57 @@ void MainWindow::onExportFile()
     QString filename = QFileDialog::getSaveFileName(this, "导出文件", "", filter);
     
     if (!filename.isEmpty()) {
-        // 导出第一个形状（可以扩展为导出所有或选中的）
-        TopoDS_Shape shape = m_document->getShape(0);
-        if (FileIO::exportFile(filename, shape)) {
-            m_statusLabel->setText(QString("已导出: %1").arg(filename));
+        // 有选中对象时导出选中的形状，否则导出文档中的全部形状
+        QList<int> indices;
+        for (const auto& obj : m_selectionManager->getSelectedObjects()) {
+            int index = m_document->findObjectIndex(obj);
+            if (index >= 0 && !indices.contains(index)) {
+                indices.append(index);
+            }
+        }
+        if (indices.isEmpty()) {
+            indices = allShapeIndices();
+        }
+        
+        // 延迟加载的零件实例先转换，未加载的形状并行恢复，不导出占位长方体
+        if (!resolveLazyInstances(indices)) {
+            return;
+        }
+        m_document->loadShapes(indices);
+        TopoDS_Shape shape;
+        if (indices.size() == 1) {
+            shape = m_document->getShape(indices.first());
+        } else {
+            TopoDS_Compound compound;
+            BRep_Builder builder;
+            builder.MakeCompound(compound);
+            for (int index : indices) {
+                builder.Add(compound, m_document->getShape(index));
+            }
+            shape = compound;
+        }
+        
+        ExportOptions options;
+        QString suffix = QFileInfo(filename).suffix().toLower();
+        if (suffix == "stl" || suffix == "obj" || suffix == "gltf" || suffix == "glb") {
+            bool ok = false;
+            QStringList presets = FileIO::getMeshPresetNames();
+            QString preset = QInputDialog::getItem(this, "导出选项", "剖分精度:", presets, 1, false, &ok);
+            if (!ok) {
+                return;
+            }
+            FileIO::applyMeshPreset(options, static_cast<MeshPreset>(presets.indexOf(preset)));
+        }
+        if (suffix == "gltf" || suffix == "glb") {
+            options.quantize = QMessageBox::question(this, "导出选项",
+                "是否将位置和法线量化为16位（KHR_mesh_quantization）？\n量化后文件更小，适合网页预览。")
+                == QMessageBox::Yes;
+        }
+        
+        // 网格格式的导出器原地剖分文档中的形状，不能与读取同一三角剖分的自动保存同时进行
+        m_document->waitForAutosave();
+        if (FileIO::exportFile(filename, shape, options)) {
+            m_statusLabel->setText(QString("已导出 %1 个形状: %2").arg(indices.size()).arg(filename));
         } else {
             QMessageBox::warning(this, "错误", "无法导出文件");
         }
@@ -279,6 +759,25 @@ void MainWindow::onExportFile()
 }
 
 void MainWindow::onSaveFile()
+{
+    // 已打开或保存过的文件直接保存（版本6文件只追加修改），否则与另存为相同
+    const QString filename = m_document->fileName();
+    if (filename.isEmpty()) {
+        onSaveFileAs();
+        return;
+    }
+    // 延迟加载的零件实例先转换，否则占位长方体会作为几何保存
+    if (!resolveLazyInstances(allShapeIndices())) {
+        return;
+    }
+    if (m_document->saveToFile(filename)) {
+        m_statusLabel->setText(QString("已保存: %1").arg(filename));
+    } else {
+        QMessageBox::warning(this, "错误", "无法保存文件");
+    }
+}
+
+void MainWindow::onSaveFileAs()
 {
     QString filename = QFileDialog::getSaveFileName(this, "保存文件", "", 
                                                     "MyCad文件 (*.mycad);;所有文件 (*.*)");
@@ -286,6 +785,9 @@ void MainWindow::onSaveFile()
         if (!filename.endsWith(".mycad", Qt::CaseInsensitive)) {
             filename += ".mycad";
         }
+        if (!resolveLazyInstances(allShapeIndices())) {
+            return;
+        }
         if (m_document->saveToFile(filename)) {
             m_statusLabel->setText(QString("已保存: %1").arg(filename));
         } else {
@@ -294,6 +796,35 @@ void MainWindow::onSaveFile()
     }
 }
 
+QString MainWindow::autosavePath() const
+{
+    // 每个进程单独的文件，多个窗口同时运行时互不覆盖
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+           + QString("/autosave/autosave-%1.mycad").arg(QCoreApplication::applicationPid());
+}
+
+void MainWindow::onAutosave()
+{
+    // 快照在这里同步取得，写文件在后台线程进行
+    // 定时保存不在后台转换延迟加载的零件实例，仍有占位对象时跳过，以免把包围盒写成几何
+    if (hasLazyPlaceholders()) {
+        qDebug() << "MainWindow::onAutosave() - 文档中有未加载的零件实例，跳过自动保存";
+        return;
+    }
+    if (!m_document->isEmpty()) {
+        m_document->startAutosave(autosavePath());
+    }
+}
+
+void MainWindow::onAutosaveFinished(const QString& filename, bool ok)
+{
+    if (ok) {
+        m_statusLabel->setText(QString("已自动保存: %1").arg(filename));
+    } else {
+        qWarning() << "MainWindow::onAutosaveFinished() - 自动保存失败:" << filename;
+    }
+}
+
 void MainWindow::onViewTop()
 {
     m_view3D->setViewTop();
@@ -0,0 +1,26 @@
+﻿#include "MycadCompactTask.h"
+#include "MycadFile.h"
+#include <QDebug>
+
+MycadCompactTask::MycadCompactTask(const QString& filename, qint64 journalEnd, QObject* parent)
+    : QThread(parent)
+    , m_fileName(filename)
+    , m_journalEnd(journalEnd)
+    , m_succeeded(false)
+    , m_fileSize(0)
+{
+}
+
+MycadCompactTask::~MycadCompactTask()
+{
+    // 整理只写临时文件，退出时等待写完即可
+    wait();
+}
+
+void MycadCompactTask::run()
+{
+    m_succeeded = MycadFile::compact(m_fileName, targetName(), m_journalEnd, m_offsets, m_fileSize);
+    if (!m_succeeded) {
+        qDebug() << "MycadCompactTask::run() - 未完成整理:" << m_fileName;
+    }
+}
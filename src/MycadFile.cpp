@@ -0,0 +1,363 @@
+﻿#include "MycadFile.h"
+#include <QDataStream>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <Standard_Failure.hxx>
+#include <gp_Trsf.hxx>
+#include <algorithm>
+
+namespace {
+
+// 版本6文件头：版本号、日志起点、已提交的日志末尾
+const qint64 THE_JOURNAL_END_POS = 12;
+
+bool validRange(qint64 fileSize, quint64 offset, quint64 size)
+{
+    return offset <= quint64(fileSize) && size <= quint64(fileSize) - offset;
+}
+
+} // namespace
+
+bool MycadFile::readIndex(QIODevice& device, Index& index)
+{
+    index = Index();
+    const qint64 fileSize = device.size();
+    device.seek(0);
+    QDataStream in(&device);
+    in >> index.version;
+    if (index.version < FORMAT_INDEXED || index.version > FORMAT_JOURNAL) {
+        return false;
+    }
+    
+    quint64 journalStart = quint64(fileSize);
+    quint64 journalEnd = quint64(fileSize);
+    if (index.version >= FORMAT_JOURNAL) {
+        in >> journalStart >> journalEnd;
+        if (journalStart > journalEnd || journalEnd > quint64(fileSize)) {
+            return false;
+        }
+    }
+    index.journalStart = qint64(journalStart);
+    index.journalEnd = qint64(journalEnd);
+    
+    quint32 count = 0;
+    in >> count;
+    if (index.version >= FORMAT_MESHED) {
+        in >> index.deviationCoefficient >> index.deviationAngle;
+    }
+    
+    std::vector<Block> blocks;
+    if (index.version >= FORMAT_SHARED) {
+        quint32 nbBlocks = 0;
+        in >> nbBlocks;
+        for (quint32 b = 0; b < nbBlocks && in.status() == QDataStream::Ok; ++b) {
+            Block block;
+            quint64 offset = 0;
+            quint64 size = 0;
+            in >> block.flags >> offset >> size;
+            if (!validRange(fileSize, offset, size)) {
+                return false;
+            }
+            block.offset = qint64(offset);
+            block.size = qint64(size);
+            blocks.push_back(block);
+        }
+    }
+    
+    index.entries.reserve(std::min<quint32>(count, 1 << 20));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Entry entry;
+        entry.record = i + 1;
+        if (index.version >= FORMAT_JOURNAL) {
+            in >> entry.record;
+        }
+        in >> entry.name;
+        readBox(in, entry.box);
+        if (index.version >= FORMAT_SHARED) {
+            quint32 block = 0;
+            quint8 orientation = 0;
+            in >> block >> orientation;
+            if (block >= blocks.size() || orientation > TopAbs_EXTERNAL || !readLocation(in, entry.location)) {
+                return false;
+            }
+            entry.flags = blocks[block].flags;
+            entry.offset = blocks[block].offset;
+            entry.size = blocks[block].size;
+            entry.orientation = TopAbs_Orientation(orientation);
+        } else {
+            quint64 offset = 0;
+            quint64 size = 0;
+            if (index.version >= FORMAT_MESHED) {
+                in >> entry.flags;
+            }
+            in >> offset >> size;
+            if (!validRange(fileSize, offset, size)) {
+                return false;
+            }
+            entry.offset = qint64(offset);
+            entry.size = qint64(size);
+        }
+        index.nextRecord = std::max(index.nextRecord, entry.record + 1);
+        index.entries.push_back(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    
+    // 回放日志：替换的形状保持原来的顺序，新增的形状追加在末尾，删除的形状先标记再统一移除
+    if (index.journalEnd > index.journalStart) {
+        QHash<quint32, size_t> positions;
+        for (size_t i = 0; i < index.entries.size(); ++i) {
+            positions.insert(index.entries[i].record, i);
+        }
+        device.seek(index.journalStart);
+        while (device.pos() < index.journalEnd) {
+            quint8 type = 0;
+            in >> type;
+            if (type == RECORD_DATA) {
+                quint64 size = 0;
+                in >> size;
+                const qint64 start = device.pos();
+                if (!validRange(index.journalEnd, quint64(start), size)) {
+                    return false;
+                }
+                device.seek(start + qint64(size));
+            } else if (type == RECORD_PUT) {
+                Entry entry;
+                quint8 orientation = 0;
+                quint64 offset = 0;
+                quint64 size = 0;
+                in >> entry.record >> entry.name;
+                readBox(in, entry.box);
+                in >> entry.flags >> orientation;
+                if (orientation > TopAbs_EXTERNAL || !readLocation(in, entry.location)) {
+                    return false;
+                }
+                in >> offset >> size;
+                if (entry.record == 0 || !validRange(index.journalEnd, offset, size)) {
+                    return false;
+                }
+                entry.orientation = TopAbs_Orientation(orientation);
+                entry.offset = qint64(offset);
+                entry.size = qint64(size);
+                index.nextRecord = std::max(index.nextRecord, entry.record + 1);
+                auto it = positions.find(entry.record);
+                if (it != positions.end()) {
+                    index.entries[it.value()] = entry;
+                } else {
+                    positions.insert(entry.record, index.entries.size());
+                    index.entries.push_back(entry);
+                }
+            } else if (type == RECORD_REMOVE) {
+                quint32 record = 0;
+                in >> record;
+                auto it = positions.find(record);
+                if (it != positions.end()) {
+                    index.entries[it.value()].record = 0;
+                    positions.erase(it);
+                }
+            } else {
+                return false;
+            }
+            if (in.status() != QDataStream::Ok) {
+                return false;
+            }
+            ++index.nbJournalRecords;
+        }
+        index.entries.erase(std::remove_if(index.entries.begin(), index.entries.end(),
+                                           [](const Entry& entry) { return entry.record == 0; }),
+                            index.entries.end());
+    }
+    return true;
+}
+
+void MycadFile::writeDirectory(QDataStream& out, qint64 journalStart, qint64 journalEnd,
+                               double deviationCoefficient, double deviationAngle,
+                               const std::vector<Block>& blocks, const std::vector<Entry>& entries)
+{
+    out << FORMAT_JOURNAL << quint64(journalStart) << quint64(journalEnd);
+    out << quint32(entries.size());
+    out << deviationCoefficient << deviationAngle;
+    out << quint32(blocks.size());
+    for (const Block& block : blocks) {
+        out << block.flags << quint64(block.offset) << quint64(block.size);
+    }
+    for (const Entry& entry : entries) {
+        out << entry.record << entry.name;
+        writeBox(out, entry.box);
+        out << quint32(entry.block) << quint8(entry.orientation);
+        writeLocation(out, entry.location);
+    }
+}
+
+void MycadFile::writeDataRecord(QDataStream& out, qint64 size)
+{
+    out << quint8(RECORD_DATA) << quint64(size);
+}
+
+void MycadFile::writePutRecord(QDataStream& out, const Entry& entry)
+{
+    out << quint8(RECORD_PUT) << entry.record << entry.name;
+    writeBox(out, entry.box);
+    out << entry.flags << quint8(entry.orientation);
+    writeLocation(out, entry.location);
+    out << quint64(entry.offset) << quint64(entry.size);
+}
+
+void MycadFile::writeRemoveRecord(QDataStream& out, quint32 record)
+{
+    out << quint8(RECORD_REMOVE) << record;
+}
+
+bool MycadFile::commitJournal(QIODevice& device, qint64 journalEnd)
+{
+    if (!device.seek(THE_JOURNAL_END_POS)) {
+        return false;
+    }
+    QDataStream out(&device);
+    out << quint64(journalEnd);
+    return out.status() == QDataStream::Ok;
+}
+
+bool MycadFile::compact(const QString& source, const QString& target, qint64 expectedJournalEnd,
+                        QHash<qint64, qint64>& offsets, qint64& fileSize)
+{
+    QElapsedTimer timer;
+    timer.start();
+    offsets.clear();
+    
+    QFile input(source);
+    Index index;
+    if (!input.open(QIODevice::ReadOnly) || !readIndex(input, index) || index.version != FORMAT_JOURNAL) {
+        qWarning() << "MycadFile::compact() - 无法读取目录:" << source;
+        return false;
+    }
+    if (index.journalEnd != expectedJournalEnd) {
+        qDebug() << "MycadFile::compact() - 文件已变化，放弃整理:" << source;
+        return false;
+    }
+    const uchar* mapped = input.map(0, input.size());
+    
+    // 同一数据块只复制一次
+    std::vector<Block> blocks;
+    QHash<qint64, int> blockOfOffset;
+    for (Entry& entry : index.entries) {
+        auto it = blockOfOffset.find(entry.offset);
+        if (it == blockOfOffset.end()) {
+            Block block;
+            block.flags = entry.flags;
+            block.offset = entry.offset;
+            block.size = entry.size;
+            it = blockOfOffset.insert(entry.offset, int(blocks.size()));
+            blocks.push_back(block);
+        }
+        entry.block = it.value();
+    }
+    
+    QFile output(target);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "MycadFile::compact() - 无法写入:" << target << output.errorString();
+        return false;
+    }
+    QDataStream out(&output);
+    writeDirectory(out, 0, 0, index.deviationCoefficient, index.deviationAngle, blocks, index.entries);
+    
+    QByteArray buffer;
+    bool ok = out.status() == QDataStream::Ok;
+    for (Block& block : blocks) {
+        if (!ok) {
+            break;
+        }
+        const qint64 offset = output.pos();
+        if (mapped != nullptr) {
+            ok = output.write(reinterpret_cast<const char*>(mapped) + block.offset, block.size) == block.size;
+        } else {
+            input.seek(block.offset);
+            buffer = input.read(block.size);
+            ok = buffer.size() == block.size && output.write(buffer) == block.size;
+        }
+        offsets.insert(block.offset, offset);
+        block.offset = offset;
+    }
+    if (mapped != nullptr) {
+        input.unmap(const_cast<uchar*>(mapped));
+    }
+    
+    fileSize = output.pos();
+    if (ok) {
+        output.seek(0);
+        writeDirectory(out, fileSize, fileSize, index.deviationCoefficient, index.deviationAngle, blocks, index.entries);
+        ok = out.status() == QDataStream::Ok && output.flush();
+    }
+    output.close();
+    if (!ok) {
+        qWarning() << "MycadFile::compact() - 写入失败:" << target;
+        QFile::remove(target);
+        return false;
+    }
+    
+    qDebug() << "MycadFile::compact() -" << source << "形状:" << index.entries.size() << "数据块:" << blocks.size()
+             << "日志记录:" << index.nbJournalRecords << "大小(字节):" << input.size() << "->" << fileSize
+             << "耗时(ms):" << timer.elapsed();
+    return true;
+}
+
+void MycadFile::writeBox(QDataStream& out, const Bnd_Box& box)
+{
+    Standard_Real xMin = 1.0, yMin = 1.0, zMin = 1.0, xMax = -1.0, yMax = -1.0, zMax = -1.0;
+    if (!box.IsVoid()) {
+        box.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+    }
+    out << xMin << yMin << zMin << xMax << yMax << zMax;
+}
+
+void MycadFile::readBox(QDataStream& in, Bnd_Box& box)
+{
+    double xMin, yMin, zMin, xMax, yMax, zMax;
+    in >> xMin >> yMin >> zMin >> xMax >> yMax >> zMax;
+    box.SetVoid();
+    if (xMin <= xMax && yMin <= yMax && zMin <= zMax) {
+        box.Update(xMin, yMin, zMin, xMax, yMax, zMax);
+    }
+}
+
+void MycadFile::writeLocation(QDataStream& out, const TopLoc_Location& location)
+{
+    out << quint8(location.IsIdentity() ? 0 : 1);
+    if (location.IsIdentity()) {
+        return;
+    }
+    const gp_Trsf trsf = location.Transformation();
+    for (int row = 1; row <= 3; ++row) {
+        for (int col = 1; col <= 4; ++col) {
+            out << trsf.Value(row, col);
+        }
+    }
+}
+
+bool MycadFile::readLocation(QDataStream& in, TopLoc_Location& location)
+{
+    quint8 hasLocation = 0;
+    in >> hasLocation;
+    location = TopLoc_Location();
+    if (hasLocation == 0) {
+        return true;
+    }
+    double m[3][4];
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            in >> m[row][col];
+        }
+    }
+    try {
+        gp_Trsf trsf;
+        trsf.SetValues(m[0][0], m[0][1], m[0][2], m[0][3],
+                       m[1][0], m[1][1], m[1][2], m[1][3],
+                       m[2][0], m[2][1], m[2][2], m[2][3]);
+        location = TopLoc_Location(trsf);
+    } catch (const Standard_Failure&) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,252 @@
+﻿#include "MycadWriter.h"
+#include <Prs3d_Drawer.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <BinTools.hxx>
+#include <BRepBndLib.hxx>
+#include <TopAbs.hxx>
+#include <OSD_Parallel.hxx>
+#include <Standard_Failure.hxx>
+#include <QDataStream>
+#include <QIODevice>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+
+namespace {
+
+// 把 BinTools 的输出直接写入文件，不在内存中拼接整个形状
+class DeviceOutBuf : public std::streambuf
+{
+public:
+    explicit DeviceOutBuf(QIODevice* device)
+        : m_device(device)
+        , m_buffer(1 << 16)
+        , m_failed(false)
+    {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+    
+    ~DeviceOutBuf() override { sync(); }
+    
+    bool failed() const { return m_failed; }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (sync() != 0) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+    
+    int sync() override
+    {
+        const qint64 size = pptr() - pbase();
+        if (size > 0 && m_device->write(pbase(), size) != size) {
+            m_failed = true;
+            return -1;
+        }
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        return 0;
+    }
+
+private:
+    QIODevice* m_device;
+    std::vector<char> m_buffer;
+    bool m_failed;
+};
+
+} // namespace
+
+MycadWriter::MycadWriter()
+    : m_threadCount(std::max(1, QThread::idealThreadCount()))
+{
+}
+
+TopoDS_Shape MycadWriter::placeInstance(const TopoDS_Shape& base, const TopLoc_Location& location,
+                                        TopAbs_Orientation orientation)
+{
+    TopoDS_Shape shape = base.Moved(location);
+    shape.Orientation(TopAbs::Compose(base.Orientation(), orientation));
+    return shape;
+}
+
+void MycadWriter::collect(const Snapshot& snapshot, bool copyStored)
+{
+    // 共享形状表：引用同一 TShape 的形状（阵列、平移等副本）只写一次基础形状，
+    // 各形状只记录引用的数据块和自身的位置、方向；未加载的形状按源文件中的数据块归并
+    m_entries.assign(snapshot.items.size(), MycadFile::Entry());
+    m_blocks.clear();
+    m_bases.clear();
+    m_baseBoxes.clear();
+    m_sourceOffsets.clear();
+    QHash<const void*, int> byTShape;
+    QHash<qint64, int> byOffset;
+    for (size_t k = 0; k < snapshot.items.size(); ++k) {
+        const Item& item = snapshot.items[k];
+        MycadFile::Entry& entry = m_entries[k];
+        entry = item.stored;
+        entry.block = -1;
+        if (item.shape.IsNull() && !copyStored) {
+            // 追加日志时未加载的形状已在同一文件中，直接引用
+            continue;
+        }
+        TopoDS_Shape shape = item.shape;
+        if (shape.IsNull() && snapshot.loadedBases.contains(item.stored.offset)) {
+            shape = placeInstance(snapshot.loadedBases.value(item.stored.offset), item.stored.location,
+                                  item.stored.orientation);
+        }
+        
+        if (shape.IsNull()) {
+            auto it = byOffset.find(item.stored.offset);
+            if (it == byOffset.end()) {
+                MycadFile::Block block;
+                block.flags = item.stored.flags;
+                block.size = item.stored.size;
+                it = byOffset.insert(item.stored.offset, int(m_blocks.size()));
+                m_blocks.push_back(block);
+                m_bases.push_back(TopoDS_Shape());
+                m_sourceOffsets.push_back(item.stored.offset);
+            }
+            entry.block = it.value();
+        } else {
+            auto it = byTShape.find(shape.TShape().get());
+            if (it == byTShape.end()) {
+                it = byTShape.insert(shape.TShape().get(), int(m_blocks.size()));
+                m_blocks.push_back(MycadFile::Block());
+                m_bases.push_back(shape.Located(TopLoc_Location()).Oriented(TopAbs_FORWARD));
+                m_sourceOffsets.push_back(-1);
+            }
+            entry.block = it.value();
+            entry.location = shape.Location();
+            entry.orientation = shape.Orientation();
+        }
+    }
+    m_baseBoxes.assign(m_blocks.size(), Bnd_Box());
+}
+
+bool MycadWriter::writeBlocks(QIODevice& file, const Snapshot& snapshot, const uchar* sourceData, bool asRecords)
+{
+    // 每批由工作线程并行序列化为独立的字节块并计算包围盒，再按顺序写入
+    // 每批数据块数与线程数相同，内存中最多同时保留一批的数据
+    const int nbBlocks = int(m_blocks.size());
+    const int batchSize = m_threadCount;
+    QDataStream out(&file);
+    for (int batchStart = 0; batchStart < nbBlocks; batchStart += batchSize) {
+        const int batchEnd = std::min(nbBlocks, batchStart + batchSize);
+        std::vector<std::stringstream> streams(size_t(batchEnd - batchStart));
+        std::vector<char> written(streams.size(), 0);
+        OSD_Parallel::For(batchStart, batchEnd, [&](int b) {
+            const TopoDS_Shape& base = m_bases[size_t(b)];
+            if (base.IsNull()) {
+                written[size_t(b - batchStart)] = 1;
+                return;
+            }
+            try {
+                // 已显示的形状带有按当前精度剖分的三角网格，这里只检查不重新剖分
+                // （多个形状可能共享面，并行剖分不安全）；计算偏差会修改 drawer，每个数据块单独创建
+                Handle(Prs3d_Drawer) drawer = new Prs3d_Drawer();
+                drawer->SetDeviationCoefficient(snapshot.deviationCoefficient);
+                drawer->SetDeviationAngle(snapshot.deviationAngle);
+                m_blocks[size_t(b)].flags = StdPrs_ToolTriangulatedShape::IsTessellated(base, drawer)
+                                            ? MycadFile::FLAG_MESHED : 0;
+                
+                std::stringstream& stream = streams[size_t(b - batchStart)];
+                BinTools::Write(base, stream);
+                BRepBndLib::Add(base, m_baseBoxes[size_t(b)]);
+                written[size_t(b - batchStart)] = stream.good() ? 1 : 0;
+            } catch (const Standard_Failure& e) {
+                qWarning() << "MycadWriter::writeBlocks() - OpenCascade异常:" << e.GetMessageString();
+            }
+        }, batchEnd - batchStart == 1);
+        
+        for (int b = batchStart; b < batchEnd; ++b) {
+            MycadFile::Block& block = m_blocks[size_t(b)];
+            std::stringstream& stream = streams[size_t(b - batchStart)];
+            const bool copied = m_bases[size_t(b)].IsNull();
+            bool ok = written[size_t(b - batchStart)] != 0;
+            if (ok && !copied) {
+                block.size = qint64(stream.tellp());
+            }
+            if (ok && asRecords) {
+                MycadFile::writeDataRecord(out, block.size);
+                ok = out.status() == QDataStream::Ok;
+            }
+            const qint64 offset = file.pos();
+            if (ok && copied) {
+                ok = sourceData != nullptr
+                     && file.write(reinterpret_cast<const char*>(sourceData) + m_sourceOffsets[size_t(b)], block.size)
+                        == block.size;
+            } else if (ok) {
+                // 通过流缓冲区分段写出，不再复制整个字节块
+                DeviceOutBuf buffer(&file);
+                std::ostream output(&buffer);
+                output << stream.rdbuf();
+                output.flush();
+                ok = !buffer.failed();
+                std::stringstream().swap(stream);
+            }
+            if (!ok) {
+                qWarning() << "MycadWriter::writeBlocks() - 写入数据块失败:" << b << file.errorString();
+                return false;
+            }
+            block.offset = offset;
+        }
+    }
+    
+    // 已序列化的形状：包围盒由基础形状的包围盒按各自的位置变换得到
+    for (MycadFile::Entry& entry : m_entries) {
+        if (entry.block < 0) {
+            continue;
+        }
+        const MycadFile::Block& block = m_blocks[size_t(entry.block)];
+        entry.offset = block.offset;
+        entry.size = block.size;
+        entry.flags = block.flags;
+        if (!m_bases[size_t(entry.block)].IsNull()) {
+            const Bnd_Box& box = m_baseBoxes[size_t(entry.block)];
+            entry.box = entry.location.IsIdentity() ? box : box.Transformed(entry.location.Transformation());
+        }
+    }
+    return true;
+}
+
+bool MycadWriter::write(QIODevice& file, const Snapshot& snapshot, const uchar* sourceData)
+{
+    collect(snapshot, true);
+    
+    // 目录：文件头、数据块表和形状表，各项长度在写入数据前已确定，写完数据后原位回填
+    QDataStream out(&file);
+    const qint64 start = file.pos();
+    MycadFile::writeDirectory(out, 0, 0, snapshot.deviationCoefficient, snapshot.deviationAngle, m_blocks, m_entries);
+    if (out.status() != QDataStream::Ok || !writeBlocks(file, snapshot, sourceData, false)) {
+        return false;
+    }
+    
+    // 日志为空：起点和末尾都在文件末尾
+    const qint64 end = file.pos();
+    file.seek(start);
+    MycadFile::writeDirectory(out, end, end, snapshot.deviationCoefficient, snapshot.deviationAngle, m_blocks, m_entries);
+    file.seek(end);
+    return out.status() == QDataStream::Ok;
+}
+
+bool MycadWriter::appendRecords(QIODevice& file, const Snapshot& snapshot)
+{
+    collect(snapshot, false);
+    if (!writeBlocks(file, snapshot, nullptr, true)) {
+        return false;
+    }
+    QDataStream out(&file);
+    for (const MycadFile::Entry& entry : m_entries) {
+        MycadFile::writePutRecord(out, entry);
+    }
+    return out.status() == QDataStream::Ok;
+}
@@ -0,0 +1,361 @@
+﻿#include "ObjReader.h"
+#include "FileIO.h"
+#include <OSD_Parallel.hxx>
+#include <Poly_Triangle.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Vec3f.hxx>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// 每个块的最小字节数，避免小文件被切得过碎
+const qint64 THE_MIN_CHUNK_SIZE = 1 << 20;
+
+// 流式读取时每块的字节数
+const qint64 THE_STREAM_BLOCK = 8 * 1024 * 1024;
+
+// 单个块的解析结果
+struct ObjChunk
+{
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::vector<float> positions;                   // x y z 连续存放
+    std::vector<int> indices;                       // 每三个为一个三角形（1基索引）
+    std::vector<std::pair<size_t, int>> relative;   // 负索引：indices中的位置 -> 块内1基索引
+    int nbVertices = 0;
+    int vertexOffset = 0;                           // 之前所有块的顶点总数
+    int triangleOffset = 0;                         // 之前所有块的三角形总数
+    int nbInvalid = 0;
+};
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline bool parseFloat(const char*& p, const char* end, float& value)
+{
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    std::from_chars_result res = std::from_chars(p, end, value);
+    if (res.ec != std::errc()) {
+        return false;
+    }
+    p = res.ptr;
+    return true;
+}
+
+void parseVertex(const char* p, const char* lineEnd, ObjChunk& chunk)
+{
+    float xyz[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 3; ++i) {
+        if (!parseFloat(p, lineEnd, xyz[i])) {
+            break;
+        }
+    }
+    chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+    ++chunk.nbVertices;
+}
+
+void parseFace(const char* p, const char* lineEnd, ObjChunk& chunk,
+               std::vector<std::pair<int, bool>>& polygon)
+{
+    polygon.clear();
+    for (;;) {
+        p = skipBlanks(p, lineEnd);
+        if (p >= lineEnd) {
+            break;
+        }
+        int index = 0;
+        std::from_chars_result res = std::from_chars(p, lineEnd, index);
+        if (res.ec != std::errc()) {
+            break;
+        }
+        // 跳过 /vt/vn 部分
+        p = res.ptr;
+        while (p < lineEnd && !isBlank(*p)) {
+            ++p;
+        }
+        if (index < 0) {
+            // 相对索引：-1 表示当前之前最后一个顶点，先记录块内位置，合并时再换算
+            polygon.emplace_back(chunk.nbVertices + index + 1, true);
+        } else {
+            polygon.emplace_back(index, false);
+        }
+    }
+
+    // 扇形剖分多边形
+    for (size_t k = 1; k + 1 < polygon.size(); ++k) {
+        const std::pair<int, bool>* corners[3] = { &polygon[0], &polygon[k], &polygon[k + 1] };
+        for (const std::pair<int, bool>* corner : corners) {
+            if (corner->second) {
+                chunk.relative.emplace_back(chunk.indices.size(), corner->first);
+            }
+            chunk.indices.push_back(corner->first);
+        }
+    }
+}
+
+void parseChunk(ObjChunk& chunk)
+{
+    std::vector<std::pair<int, bool>> polygon;
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* newLine = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+        const char* lineEnd = newLine != nullptr ? newLine : chunk.end;
+        const char* q = skipBlanks(p, lineEnd);
+        if (q + 1 < lineEnd && isBlank(q[1])) {
+            if (q[0] == 'v') {
+                parseVertex(q + 1, lineEnd, chunk);
+            } else if (q[0] == 'f') {
+                parseFace(q + 1, lineEnd, chunk, polygon);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+// 合并各块的解析结果：计算每个块的顶点和三角形偏移，直接填充单精度三角网格
+Handle(Poly_Triangulation) buildTriangulation(std::vector<ObjChunk>& chunks, bool singleThread, QElapsedTimer& timer,
+                                              ObjReader::Statistics& stats)
+{
+    const int nbChunks = int(chunks.size());
+    qint64 nbNodes = 0;
+    qint64 nbTriangles = 0;
+    qint64 bufferBytes = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.vertexOffset = int(nbNodes);
+        chunk.triangleOffset = int(nbTriangles);
+        nbNodes += chunk.nbVertices;
+        nbTriangles += qint64(chunk.indices.size() / 3);
+        bufferBytes += qint64(chunk.positions.capacity() * sizeof(float))
+                     + qint64(chunk.indices.capacity() * sizeof(int))
+                     + qint64(chunk.relative.capacity() * sizeof(std::pair<size_t, int>));
+    }
+
+    if (nbNodes == 0 || nbTriangles == 0 || nbNodes > INT_MAX || nbTriangles > INT_MAX) {
+        qWarning() << "ObjReader::read() - 没有可用的网格数据，顶点:" << nbNodes << "三角形:" << nbTriangles;
+        return Handle(Poly_Triangulation)();
+    }
+
+    // 第二遍：直接填充单精度三角网格，填充完的块立即释放缓冲区
+    Handle(Poly_Triangulation) triangulation = new Poly_Triangulation();
+    triangulation->SetDoublePrecision(false);
+    triangulation->ResizeNodes(int(nbNodes), false);
+    triangulation->ResizeTriangles(int(nbTriangles), false);
+
+    const int totalNodes = int(nbNodes);
+    OSD_Parallel::For(0, nbChunks, [&chunks, &triangulation, totalNodes](int i) {
+        ObjChunk& chunk = chunks[i];
+        for (int v = 0; v < chunk.nbVertices; ++v) {
+            const float* xyz = &chunk.positions[size_t(v) * 3];
+            triangulation->SetNode(chunk.vertexOffset + v + 1, gp_Pnt(xyz[0], xyz[1], xyz[2]));
+        }
+        std::vector<float>().swap(chunk.positions);
+
+        for (const std::pair<size_t, int>& rel : chunk.relative) {
+            chunk.indices[rel.first] = chunk.vertexOffset + rel.second;
+        }
+        const int nbChunkTriangles = int(chunk.indices.size() / 3);
+        for (int t = 0; t < nbChunkTriangles; ++t) {
+            int n1 = chunk.indices[size_t(t) * 3];
+            int n2 = chunk.indices[size_t(t) * 3 + 1];
+            int n3 = chunk.indices[size_t(t) * 3 + 2];
+            if (n1 < 1 || n1 > totalNodes || n2 < 1 || n2 > totalNodes || n3 < 1 || n3 > totalNodes) {
+                n1 = n2 = n3 = 1;
+                ++chunk.nbInvalid;
+            }
+            triangulation->SetTriangle(chunk.triangleOffset + t + 1, Poly_Triangle(n1, n2, n3));
+        }
+        std::vector<int>().swap(chunk.indices);
+        std::vector<std::pair<size_t, int>>().swap(chunk.relative);
+    }, singleThread);
+    stats.buildMs = timer.elapsed();
+
+    for (const ObjChunk& chunk : chunks) {
+        stats.nbInvalidFaces += chunk.nbInvalid;
+    }
+    stats.nbNodes = int(nbNodes);
+    stats.nbTriangles = int(nbTriangles);
+    stats.peakBytes = bufferBytes
+                    + nbNodes * qint64(sizeof(gp_Vec3f))
+                    + nbTriangles * qint64(sizeof(Poly_Triangle));
+    return triangulation;
+}
+
+} // namespace
+
+ObjReader::ObjReader(int threadCount)
+    : m_threadCount(FileIO::resolveThreadCount(threadCount))
+{
+}
+
+qint64 ObjReader::memoryBound(qint64 nbNodes, qint64 nbTriangles)
+{
+    // 解析缓冲区（std::vector 扩容最多两倍）+ 单精度节点和三角形数组
+    const qint64 perNode = 2 * 3 * qint64(sizeof(float)) + qint64(sizeof(gp_Vec3f));
+    const qint64 perTriangle = 2 * 3 * qint64(sizeof(int)) + qint64(sizeof(Poly_Triangle));
+    return nbNodes * perNode + nbTriangles * perTriangle;
+}
+
+bool ObjReader::read(const QString& filename)
+{
+    m_triangulation.Nullify();
+    m_stats = Statistics();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "ObjReader::read() - 无法打开文件:" << filename;
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    m_stats.fileSize = fileSize;
+    if (fileSize == 0) {
+        return false;
+    }
+
+    uchar* mapped = file.map(0, fileSize);
+    if (mapped == nullptr) {
+        qWarning() << "ObjReader::read() - 内存映射失败:" << file.errorString();
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(mapped);
+    const char* dataEnd = data + fileSize;
+
+    // 按行边界切分文件
+    const int nbChunks = int(std::max<qint64>(1, std::min<qint64>(m_threadCount * 4, fileSize / THE_MIN_CHUNK_SIZE)));
+    std::vector<ObjChunk> chunks(nbChunks);
+    const char* chunkBegin = data;
+    for (int i = 0; i < nbChunks; ++i) {
+        const char* chunkEnd = dataEnd;
+        if (i + 1 < nbChunks) {
+            chunkEnd = std::max(chunkBegin, data + fileSize / nbChunks * (i + 1));
+            const char* newLine = static_cast<const char*>(std::memchr(chunkEnd, '\n', dataEnd - chunkEnd));
+            chunkEnd = newLine != nullptr ? newLine + 1 : dataEnd;
+        }
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+    m_stats.nbChunks = nbChunks;
+
+    // 第一遍：各块独立解析
+    QElapsedTimer timer;
+    timer.start();
+    OSD_Parallel::For(0, nbChunks, [&chunks](int i) {
+        parseChunk(chunks[i]);
+    }, m_threadCount == 1);
+    m_stats.parseMs = timer.restart();
+
+    file.unmap(mapped);
+    file.close();
+
+    m_triangulation = buildTriangulation(chunks, m_threadCount == 1, timer, m_stats);
+    logStatistics(filename);
+    return !m_triangulation.IsNull();
+}
+
+bool ObjReader::read(QIODevice& device, const QString& name)
+{
+    m_triangulation.Nullify();
+    m_stats = Statistics();
+
+    // 每批读入与线程数相同的块，各块在最后一个换行处截断，剩余部分并入下一块；
+    // 一批解析完后缓冲区复用，文本缓冲区的内存不超过 线程数 x 块大小
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<ObjChunk> chunks;
+    std::vector<std::vector<char>> batch(size_t(m_threadCount));
+    std::vector<char> carry;
+    bool end = false;
+    while (!end) {
+        int nbBlocks = 0;
+        for (; nbBlocks < m_threadCount && !end; ++nbBlocks) {
+            std::vector<char>& buffer = batch[size_t(nbBlocks)];
+            buffer.assign(carry.begin(), carry.end());
+            size_t filled = buffer.size();
+            size_t cut = 0;
+            for (;;) {
+                buffer.resize(std::max<size_t>(size_t(THE_STREAM_BLOCK), filled * 2));
+                while (filled < buffer.size()) {
+                    const qint64 count = device.read(buffer.data() + filled, qint64(buffer.size() - filled));
+                    if (count <= 0) {
+                        end = true;
+                        break;
+                    }
+                    filled += size_t(count);
+                    m_stats.fileSize += count;
+                }
+                if (end) {
+                    cut = filled;
+                    break;
+                }
+                const char* data = buffer.data();
+                const char* lastNewLine = nullptr;
+                for (const char* p = data + filled; p > data; --p) {
+                    if (p[-1] == '\n') {
+                        lastNewLine = p - 1;
+                        break;
+                    }
+                }
+                // 单行超过块大小时继续读入
+                if (lastNewLine != nullptr) {
+                    cut = size_t(lastNewLine + 1 - data);
+                    break;
+                }
+            }
+            carry.assign(buffer.begin() + cut, buffer.begin() + filled);
+            buffer.resize(cut);
+        }
+
+        const size_t first = chunks.size();
+        chunks.resize(first + size_t(nbBlocks));
+        for (int i = 0; i < nbBlocks; ++i) {
+            chunks[first + i].begin = batch[size_t(i)].data();
+            chunks[first + i].end = batch[size_t(i)].data() + batch[size_t(i)].size();
+        }
+        OSD_Parallel::For(0, nbBlocks, [&chunks, first](int i) {
+            parseChunk(chunks[first + i]);
+            chunks[first + i].begin = nullptr;
+            chunks[first + i].end = nullptr;
+        }, m_threadCount == 1);
+    }
+    std::vector<std::vector<char>>().swap(batch);
+    m_stats.nbChunks = int(chunks.size());
+    m_stats.parseMs = timer.restart();
+
+    m_triangulation = buildTriangulation(chunks, m_threadCount == 1, timer, m_stats);
+    logStatistics(name);
+    return !m_triangulation.IsNull();
+}
+
+void ObjReader::logStatistics(const QString& filename) const
+{
+    if (m_stats.nbInvalidFaces > 0) {
+        qWarning() << "ObjReader::read() - 索引越界的三角形:" << m_stats.nbInvalidFaces;
+    }
+    qDebug() << "ObjReader::read() -" << filename
+             << "顶点:" << m_stats.nbNodes << "三角形:" << m_stats.nbTriangles
+             << "块:" << m_stats.nbChunks << "解析(ms):" << m_stats.parseMs << "构建(ms):" << m_stats.buildMs
+             << "峰值内存(MB):" << m_stats.peakBytes / (1024 * 1024)
+             << "上限(MB):" << memoryBound(m_stats.nbNodes, m_stats.nbTriangles) / (1024 * 1024);
+}
@@ -0,0 +1,234 @@
+﻿#include "ObjWriter.h"
+#include "FileIO.h"
+#include <OSD_Parallel.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepLib_ToolTriangulatedShape.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Dir.hxx>
+#include <gp.hxx>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <charconv>
+#include <future>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// 文本大小估计（字节），用于划分批次
+const qint64 THE_BYTES_PER_NODE = 2 * 40;
+const qint64 THE_BYTES_PER_TRIANGLE = 48;
+
+struct ObjFaceJob
+{
+    TopoDS_Face face;
+    Handle(Poly_Triangulation) triangulation;
+    gp_Trsf trsf;
+    qint64 vertexOffset = 0;    // 之前所有面的顶点总数
+    std::string text;
+};
+
+inline void appendFloat(std::string& out, double value)
+{
+    char buffer[32];
+    std::to_chars_result res = std::to_chars(buffer, buffer + sizeof(buffer), float(value));
+    out.append(buffer, res.ptr);
+}
+
+inline void appendIndex(std::string& out, qint64 value)
+{
+    char buffer[24];
+    std::to_chars_result res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, res.ptr);
+}
+
+void formatFace(ObjFaceJob& job)
+{
+    const Handle(Poly_Triangulation)& triangulation = job.triangulation;
+    const int nbNodes = triangulation->NbNodes();
+    const int nbTriangles = triangulation->NbTriangles();
+    const bool mirrored = job.trsf.VectorialPart().Determinant() < 0.0;
+    const bool reversed = (job.face.Orientation() == TopAbs_REVERSED) != mirrored;
+
+    std::string& out = job.text;
+    out.reserve(size_t(nbNodes * THE_BYTES_PER_NODE + nbTriangles * THE_BYTES_PER_TRIANGLE));
+
+    for (int i = 1; i <= nbNodes; ++i) {
+        const gp_Pnt point = triangulation->Node(i).Transformed(job.trsf);
+        out += "v ";
+        appendFloat(out, point.X());
+        out += ' ';
+        appendFloat(out, point.Y());
+        out += ' ';
+        appendFloat(out, point.Z());
+        out += '\n';
+    }
+    for (int i = 1; i <= nbNodes; ++i) {
+        gp_Dir normal = triangulation->HasNormals() ? triangulation->Normal(i) : gp::DZ();
+        normal.Transform(job.trsf);
+        if (reversed) {
+            normal.Reverse();
+        }
+        out += "vn ";
+        appendFloat(out, normal.X());
+        out += ' ';
+        appendFloat(out, normal.Y());
+        out += ' ';
+        appendFloat(out, normal.Z());
+        out += '\n';
+    }
+    for (int t = 1; t <= nbTriangles; ++t) {
+        Standard_Integer nodes[3];
+        triangulation->Triangle(t).Get(nodes[0], nodes[1], nodes[2]);
+        if (reversed) {
+            std::swap(nodes[1], nodes[2]);
+        }
+        out += 'f';
+        for (Standard_Integer node : nodes) {
+            const qint64 index = job.vertexOffset + node;
+            out += ' ';
+            appendIndex(out, index);
+            out += "//";
+            appendIndex(out, index);
+        }
+        out += '\n';
+    }
+}
+
+bool writeBatch(QFile& file, std::vector<ObjFaceJob>& jobs, size_t begin, size_t end)
+{
+    bool ok = true;
+    for (size_t i = begin; i < end; ++i) {
+        std::string& text = jobs[i].text;
+        ok = ok && file.write(text.data(), qint64(text.size())) == qint64(text.size());
+        std::string().swap(text);
+    }
+    return ok;
+}
+
+} // namespace
+
+ObjWriter::ObjWriter()
+    : m_linearDeflection(0.1)
+    , m_angularDeflection(0.5)
+    , m_threadCount(0)
+    , m_windowSize(32 * 1024 * 1024)
+{
+}
+
+bool ObjWriter::write(const QString& filename, const TopoDS_Shape& shape)
+{
+    m_stats = Statistics();
+    if (shape.IsNull()) {
+        return false;
+    }
+
+    const bool singleThread = FileIO::resolveThreadCount(m_threadCount) == 1;
+
+    // 剖分（BRepMesh 内部按面并行）
+    QElapsedTimer timer;
+    timer.start();
+    BRepMesh_IncrementalMesh mesher(shape, m_linearDeflection, Standard_False, m_angularDeflection, !singleThread);
+
+    // 收集面并计算顶点偏移
+    std::vector<ObjFaceJob> jobs;
+    std::vector<std::pair<TopoDS_Face, Handle(Poly_Triangulation)>> needNormals;
+    std::set<const Poly_Triangulation*> seen;
+    qint64 vertexOffset = 0;
+    for (TopExp_Explorer explorer(shape, TopAbs_FACE); explorer.More(); explorer.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(explorer.Current());
+        TopLoc_Location location;
+        Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(face, location);
+        if (triangulation.IsNull() || triangulation->NbTriangles() == 0) {
+            continue;
+        }
+        if (!triangulation->HasNormals() && seen.insert(triangulation.get()).second) {
+            needNormals.emplace_back(face, triangulation);
+        }
+        ObjFaceJob job;
+        job.face = face;
+        job.triangulation = triangulation;
+        job.trsf = location.Transformation();
+        job.vertexOffset = vertexOffset;
+        vertexOffset += triangulation->NbNodes();
+        m_stats.nbTriangles += triangulation->NbTriangles();
+        jobs.push_back(job);
+    }
+    m_stats.nbFaces = int(jobs.size());
+    m_stats.nbVertices = vertexOffset;
+
+    // 共享的三角网格只计算一次法线，避免格式化时并发写同一网格
+    OSD_Parallel::For(0, int(needNormals.size()), [&needNormals](int i) {
+        BRepLib_ToolTriangulatedShape::ComputeNormals(needNormals[i].first, needNormals[i].second);
+    }, singleThread);
+    m_stats.meshMs = timer.restart();
+
+    if (jobs.empty()) {
+        qWarning() << "ObjWriter::write() - 没有可导出的三角网格";
+        return false;
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "ObjWriter::write() - 无法写入文件:" << filename;
+        return false;
+    }
+    const QByteArray header = "# MyCad OBJ export\n";
+    bool ok = file.write(header) == header.size();
+
+    // 按估计的文本大小划分批次：格式化当前批次的同时写出上一个批次
+    std::future<bool> pendingWrite;
+    qint64 pendingBytes = 0;
+    size_t begin = 0;
+    while (begin < jobs.size()) {
+        size_t end = begin;
+        qint64 estimate = 0;
+        while (end < jobs.size() && (end == begin || estimate < m_windowSize)) {
+            estimate += jobs[end].triangulation->NbNodes() * THE_BYTES_PER_NODE
+                      + jobs[end].triangulation->NbTriangles() * THE_BYTES_PER_TRIANGLE;
+            ++end;
+        }
+
+        OSD_Parallel::For(int(begin), int(end), [&jobs](int i) {
+            formatFace(jobs[i]);
+        }, singleThread);
+
+        qint64 batchBytes = 0;
+        for (size_t i = begin; i < end; ++i) {
+            batchBytes += qint64(jobs[i].text.size());
+        }
+        m_stats.peakWindowBytes = std::max(m_stats.peakWindowBytes, batchBytes + pendingBytes);
+        m_stats.bytesWritten += batchBytes;
+        ++m_stats.nbBatches;
+
+        if (pendingWrite.valid()) {
+            ok = pendingWrite.get() && ok;
+        }
+        pendingWrite = std::async(std::launch::async, [&file, &jobs, begin, end]() {
+            return writeBatch(file, jobs, begin, end);
+        });
+        pendingBytes = batchBytes;
+        begin = end;
+    }
+    if (pendingWrite.valid()) {
+        ok = pendingWrite.get() && ok;
+    }
+    file.close();
+    m_stats.writeMs = timer.elapsed();
+
+    qDebug() << "ObjWriter::write() -" << filename
+             << "面:" << m_stats.nbFaces << "顶点:" << m_stats.nbVertices << "三角形:" << m_stats.nbTriangles
+             << "批次:" << m_stats.nbBatches << "窗口峰值(MB):" << m_stats.peakWindowBytes / (1024 * 1024)
+             << "剖分(ms):" << m_stats.meshMs << "格式化与写入(ms):" << m_stats.writeMs;
+    return ok;
+}
@@ -0,0 +1,730 @@
+﻿#include "StepParser.h"
+#include "FileIO.h"
+#include <STEPControl_Reader.hxx>
+#include <XSControl_WorkSession.hxx>
+#include <StepData_StepModel.hxx>
+#include <StepData_StepReaderData.hxx>
+#include <StepData_StepReaderTool.hxx>
+#include <StepData_Protocol.hxx>
+#include <StepData_FileRecognizer.hxx>
+#include <Interface_InterfaceModel.hxx>
+#include <Interface_ParamType.hxx>
+#include <Interface_Static.hxx>
+#include <Resource_FormatType.hxx>
+#include <OSD_Parallel.hxx>
+#include <Standard_Failure.hxx>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// 每块至少 1MB，避免小文件切得过碎
+const qint64 THE_MIN_CHUNK_SIZE = qint64(1) << 20;
+
+// 参数列表的最大嵌套深度
+const int THE_MAX_DEPTH = 64;
+
+// 不带类型的子列表记录的类型名，与OCCT的STEP分析器一致
+const char THE_SUBLIST_TYPE[] = "/* (SUB) */";
+
+// 文件头记录和复合实体后续部分的标识
+const char THE_ZERO_IDENT[] = "#0";
+
+const size_t THE_NO_TEXT = size_t(-1);
+
+struct LexParam
+{
+    size_t value;               // 文本在缓冲区中的偏移；子列表参数为子列表记录在块内的序号
+    Interface_ParamType type;
+};
+
+struct LexRecord
+{
+    size_t ident;               // 标识偏移，THE_NO_TEXT 表示文件头记录或复合实体的后续部分
+    size_t type;                // 类型名偏移，THE_NO_TEXT 表示不带类型的子列表
+    size_t firstParam;
+    int nbParams;
+    bool sub;                   // 是否为子列表记录
+};
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isLetter(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+inline bool isKeywordChar(char c)
+{
+    return isLetter(c) || isDigit(c) || c == '_' || c == '-';
+}
+
+// 跳过空白和注释，注释未结束时返回 nullptr
+const char* skipBlank(const char* pos, const char* end)
+{
+    while (pos < end) {
+        if (isSpace(*pos)) {
+            ++pos;
+        } else if (*pos == '/' && pos + 1 < end && pos[1] == '*') {
+            const char* close = pos + 2;
+            while (close + 1 < end && !(close[0] == '*' && close[1] == '/')) {
+                ++close;
+            }
+            if (close + 1 >= end) {
+                return nullptr;
+            }
+            pos = close + 2;
+        } else {
+            break;
+        }
+    }
+    return pos;
+}
+
+// 从 pos 开始查找下一个实体实例的开头（";" 之后的 "#数字="）
+const char* findEntityStart(const char* pos, const char* end)
+{
+    for (; pos < end; ++pos) {
+        if (*pos != ';') {
+            continue;
+        }
+        const char* start = pos + 1;
+        while (start < end && isSpace(*start)) {
+            ++start;
+        }
+        if (start + 1 >= end || *start != '#' || !isDigit(start[1])) {
+            continue;
+        }
+        const char* next = start + 1;
+        while (next < end && isDigit(*next)) {
+            ++next;
+        }
+        while (next < end && isSpace(*next)) {
+            ++next;
+        }
+        if (next < end && *next == '=') {
+            return start;
+        }
+    }
+    return end;
+}
+
+// 匹配 text 开头的关键字，之后可以有空白和注释
+const char* matchKeyword(const char* pos, const char* end, const char* keyword)
+{
+    pos = skipBlank(pos, end);
+    const size_t length = std::strlen(keyword);
+    if (pos == nullptr || end - pos < qint64(length) || std::memcmp(pos, keyword, length) != 0) {
+        return nullptr;
+    }
+    return pos + length;
+}
+
+// 单个文本块的分析器，输出与OCCT STEP分析器相同结构的记录：
+// 子列表（包括带类型的参数）先于引用它的记录输出，复合实体拆成连续的多条记录
+class ChunkLexer
+{
+public:
+    ChunkLexer(const char* begin, const char* end)
+        : m_pos(begin)
+        , m_end(end)
+        , m_levels(THE_MAX_DEPTH + 1)
+        , m_headerDone(false)
+    {
+        m_void = store("$", 1);
+        m_derived = store("*", 1);
+    }
+
+    // 分析块内的全部实例；header 为真时分析文件头，遇到 ENDSEC 结束
+    bool run(bool header)
+    {
+        for (;;) {
+            m_pos = skipBlank(m_pos, m_end);
+            if (m_pos == nullptr) {
+                m_pos = m_end;
+                return fail("注释未结束");
+            }
+            if (m_pos >= m_end) {
+                return !header || fail("文件头未结束");
+            }
+            if (!(header ? parseHeaderInstance() : parseInstance())) {
+                return false;
+            }
+            if (m_headerDone) {
+                return true;
+            }
+        }
+    }
+
+    // 预留参数文本缓冲区，大小与块相当
+    void reserve(size_t bytes) { m_arena.reserve(bytes); }
+
+    const char* position() const { return m_pos; }
+    const char* text(size_t offset) const { return m_arena.data() + offset; }
+    const std::vector<LexRecord>& records() const { return m_records; }
+    const std::vector<LexParam>& params() const { return m_params; }
+    const QString& error() const { return m_error; }
+
+private:
+    bool fail(const char* message)
+    {
+        if (m_error.isEmpty()) {
+            m_error = QString::fromUtf8(message);
+        }
+        return false;
+    }
+
+    // 跳过空白和注释，要求之后还有内容
+    bool expectMore()
+    {
+        const char* pos = skipBlank(m_pos, m_end);
+        if (pos == nullptr) {
+            m_pos = m_end;
+            return fail("注释未结束");
+        }
+        m_pos = pos;
+        return m_pos < m_end || fail("实例未结束");
+    }
+
+    bool expect(char c)
+    {
+        if (!expectMore()) {
+            return false;
+        }
+        if (*m_pos != c) {
+            return fail("语法错误");
+        }
+        ++m_pos;
+        return true;
+    }
+
+    size_t store(const char* text, size_t length)
+    {
+        const size_t offset = m_arena.size();
+        m_arena.insert(m_arena.end(), text, text + length);
+        m_arena.push_back('\0');
+        return offset;
+    }
+
+    size_t storeKeyword()
+    {
+        const char* start = m_pos;
+        if (m_pos >= m_end || !isLetter(*m_pos)) {
+            return THE_NO_TEXT;
+        }
+        while (m_pos < m_end && isKeywordChar(*m_pos)) {
+            ++m_pos;
+        }
+        return store(start, size_t(m_pos - start));
+    }
+
+    size_t emitRecord(size_t ident, size_t type, int depth, bool sub)
+    {
+        const std::vector<LexParam>& level = m_levels[depth];
+        LexRecord record;
+        record.ident = ident;
+        record.type = type;
+        record.firstParam = m_params.size();
+        record.nbParams = int(level.size());
+        record.sub = sub;
+        m_params.insert(m_params.end(), level.begin(), level.end());
+        m_records.push_back(record);
+        return m_records.size() - 1;
+    }
+
+    // "(" 已读入，参数收集在 m_levels[depth] 中
+    bool parseList(int depth)
+    {
+        if (depth >= THE_MAX_DEPTH) {
+            return fail("参数列表嵌套过深");
+        }
+        m_levels[depth].clear();
+        if (!expectMore()) {
+            return false;
+        }
+        if (*m_pos == ')') {
+            ++m_pos;
+            return true;
+        }
+        for (;;) {
+            if (!parseParam(depth)) {
+                return false;
+            }
+            if (!expectMore()) {
+                return false;
+            }
+            const char c = *m_pos++;
+            if (c == ')') {
+                return true;
+            }
+            if (c != ',') {
+                return fail("参数之间缺少逗号");
+            }
+            if (!expectMore()) {
+                return false;
+            }
+        }
+    }
+
+    bool parseParam(int depth)
+    {
+        LexParam param;
+        const char* start = m_pos;
+        const char c = *m_pos;
+        if (c == '#') {
+            ++m_pos;
+            while (m_pos < m_end && isDigit(*m_pos)) {
+                ++m_pos;
+            }
+            if (m_pos - start < 2) {
+                return fail("实例引用无效");
+            }
+            param.value = store(start, size_t(m_pos - start));
+            param.type = Interface_ParamIdent;
+        } else if (c == '$') {
+            ++m_pos;
+            param.value = m_void;
+            param.type = Interface_ParamVoid;
+        } else if (c == '*') {
+            ++m_pos;
+            param.value = m_derived;
+            param.type = Interface_ParamMisc;
+        } else if (c == '\'') {
+            if (!parseString(param)) {
+                return false;
+            }
+        } else if (c == '"') {
+            ++m_pos;
+            while (m_pos < m_end && *m_pos != '"') {
+                ++m_pos;
+            }
+            if (m_pos >= m_end) {
+                return fail("二进制值未结束");
+            }
+            ++m_pos;
+            param.value = store(start, size_t(m_pos - start));
+            param.type = Interface_ParamHexa;
+        } else if (c == '.') {
+            ++m_pos;
+            while (m_pos < m_end && isKeywordChar(*m_pos)) {
+                ++m_pos;
+            }
+            if (m_pos >= m_end || *m_pos != '.') {
+                return fail("枚举值未结束");
+            }
+            ++m_pos;
+            param.value = store(start, size_t(m_pos - start));
+            param.type = Interface_ParamEnum;
+        } else if (isDigit(c) || c == '+' || c == '-') {
+            bool real = false;
+            ++m_pos;
+            while (m_pos < m_end) {
+                const char d = *m_pos;
+                if (d == '.' || d == 'E' || d == 'e') {
+                    real = true;
+                } else if (!isDigit(d) && d != '+' && d != '-') {
+                    break;
+                }
+                ++m_pos;
+            }
+            param.value = store(start, size_t(m_pos - start));
+            param.type = real ? Interface_ParamReal : Interface_ParamInteger;
+        } else if (c == '(') {
+            // 不带类型的子列表
+            ++m_pos;
+            if (!parseList(depth + 1)) {
+                return false;
+            }
+            param.value = emitRecord(THE_NO_TEXT, THE_NO_TEXT, depth + 1, true);
+            param.type = Interface_ParamSub;
+        } else if (isLetter(c)) {
+            // 带类型的参数，例如 LENGTH_MEASURE(1.)
+            const size_t type = storeKeyword();
+            if (!expect('(') || !parseList(depth + 1)) {
+                return false;
+            }
+            param.value = emitRecord(THE_NO_TEXT, type, depth + 1, true);
+            param.type = Interface_ParamSub;
+        } else if (c == '@') {
+            return fail("不支持值实例");
+        } else {
+            return fail("无法识别的参数");
+        }
+        m_levels[depth].push_back(param);
+        return true;
+    }
+
+    // 字符串保留引号和转义，由 StepData_StepReaderData 读取时解码；跨行时去掉换行
+    bool parseString(LexParam& param)
+    {
+        param.value = m_arena.size();
+        param.type = Interface_ParamText;
+        m_arena.push_back('\'');
+        ++m_pos;
+        for (;;) {
+            if (m_pos >= m_end) {
+                return fail("字符串未结束");
+            }
+            const char c = *m_pos++;
+            if (c == '\'') {
+                m_arena.push_back('\'');
+                if (m_pos < m_end && *m_pos == '\'') {
+                    m_arena.push_back('\'');
+                    ++m_pos;
+                    continue;
+                }
+                break;
+            }
+            if (c != '\r' && c != '\n') {
+                m_arena.push_back(c);
+            }
+        }
+        m_arena.push_back('\0');
+        return true;
+    }
+
+    // #N = TYPE(...); 或复合实体 #N = (A(...) B(...));
+    bool parseInstance()
+    {
+        const char* start = m_pos;
+        if (*m_pos != '#') {
+            return fail("应为实例标识");
+        }
+        ++m_pos;
+        while (m_pos < m_end && isDigit(*m_pos)) {
+            ++m_pos;
+        }
+        if (m_pos - start < 2) {
+            return fail("实例标识无效");
+        }
+        const size_t ident = store(start, size_t(m_pos - start));
+        if (!expect('=') || !expectMore()) {
+            return false;
+        }
+
+        if (*m_pos == '(') {
+            ++m_pos;
+            bool first = true;
+            for (;;) {
+                if (!expectMore()) {
+                    return false;
+                }
+                if (*m_pos == ')') {
+                    ++m_pos;
+                    break;
+                }
+                const size_t type = storeKeyword();
+                if (type == THE_NO_TEXT) {
+                    return fail("复合实体中应为类型名");
+                }
+                if (!expect('(') || !parseList(0)) {
+                    return false;
+                }
+                emitRecord(first ? ident : THE_NO_TEXT, type, 0, false);
+                first = false;
+            }
+            if (first) {
+                return fail("复合实体为空");
+            }
+        } else {
+            const size_t type = storeKeyword();
+            if (type == THE_NO_TEXT) {
+                return fail("应为类型名");
+            }
+            if (!expect('(') || !parseList(0)) {
+                return false;
+            }
+            emitRecord(ident, type, 0, false);
+        }
+        return expect(';');
+    }
+
+    // TYPE(...); 直到 ENDSEC;
+    bool parseHeaderInstance()
+    {
+        const size_t type = storeKeyword();
+        if (type == THE_NO_TEXT) {
+            return fail("文件头中应为类型名");
+        }
+        if (std::strcmp(text(type), "ENDSEC") == 0) {
+            m_headerDone = true;
+            return expect(';');
+        }
+        if (!expect('(') || !parseList(0)) {
+            return false;
+        }
+        emitRecord(THE_NO_TEXT, type, 0, false);
+        return expect(';');
+    }
+
+    const char* m_pos;
+    const char* m_end;
+    std::vector<char> m_arena;                  // 以 '\0' 结尾的参数文本
+    std::vector<LexRecord> m_records;
+    std::vector<LexParam> m_params;
+    std::vector<std::vector<LexParam>> m_levels;  // 每层嵌套正在收集的参数
+    size_t m_void;
+    size_t m_derived;
+    bool m_headerDone;
+    QString m_error;
+};
+
+} // namespace
+
+StepParser::StepParser(int threadCount)
+    : m_threadCount(FileIO::resolveThreadCount(threadCount))
+{
+}
+
+bool StepParser::read(const QString& filename, STEPControl_Reader& reader)
+{
+    m_stats = Statistics();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "StepParser::read() - 无法打开文件:" << filename;
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    m_stats.fileSize = fileSize;
+    if (fileSize == 0) {
+        return false;
+    }
+    uchar* mapped = file.map(0, fileSize);
+    if (mapped == nullptr) {
+        qWarning() << "StepParser::read() - 内存映射失败:" << file.errorString();
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(mapped);
+    const char* end = data + fileSize;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 文件头：ISO-10303-21; HEADER; ... ENDSEC;
+    const char* pos = matchKeyword(data, end, "ISO-10303-21");
+    pos = pos ? matchKeyword(pos, end, ";") : nullptr;
+    pos = pos ? matchKeyword(pos, end, "HEADER") : nullptr;
+    pos = pos ? matchKeyword(pos, end, ";") : nullptr;
+    if (pos == nullptr) {
+        qWarning() << "StepParser::read() - 不是STEP文件:" << filename;
+        file.unmap(mapped);
+        return false;
+    }
+    std::unique_ptr<ChunkLexer> header(new ChunkLexer(pos, end));
+    if (!header->run(true)) {
+        qWarning() << "StepParser::read() - 文件头分析失败:" << header->error();
+        file.unmap(mapped);
+        return false;
+    }
+
+    // 只支持单个 DATA 段，末尾为 ENDSEC; END-ISO-10303-21;
+    pos = matchKeyword(header->position(), end, "DATA");
+    pos = pos ? matchKeyword(pos, end, ";") : nullptr;
+    const char* dataBegin = pos;
+    const char* dataEnd = nullptr;
+    if (dataBegin != nullptr) {
+        for (const char* p = end - 6; p >= dataBegin; --p) {
+            if (std::memcmp(p, "ENDSEC", 6) == 0) {
+                dataEnd = p;
+                break;
+            }
+        }
+    }
+    if (dataEnd != nullptr) {
+        pos = matchKeyword(dataEnd + 6, end, ";");
+        pos = pos ? matchKeyword(pos, end, "END-ISO-10303-21") : nullptr;
+        pos = pos ? matchKeyword(pos, end, ";") : nullptr;
+        if (pos == nullptr) {
+            dataEnd = nullptr;
+        }
+    }
+    if (dataEnd == nullptr) {
+        qWarning() << "StepParser::read() - 不支持的文件结构（DATA 段）:" << filename;
+        file.unmap(mapped);
+        return false;
+    }
+
+    // 在实体边界处切块，每块独立分析；切点落在字符串或注释中时，相邻块会因实例不完整而报错
+    const qint64 dataSize = dataEnd - dataBegin;
+    const int nbChunks = int(std::max<qint64>(1, std::min<qint64>(m_threadCount * 4, dataSize / THE_MIN_CHUNK_SIZE)));
+    std::vector<const char*> bounds(nbChunks + 1);
+    bounds[0] = dataBegin;
+    bounds[nbChunks] = dataEnd;
+    for (int c = 1; c < nbChunks; ++c) {
+        const char* target = std::max(bounds[c - 1], dataBegin + dataSize * c / nbChunks);
+        bounds[c] = findEntityStart(target, dataEnd);
+    }
+    m_stats.nbChunks = nbChunks;
+
+    std::vector<std::unique_ptr<ChunkLexer>> chunks(nbChunks);
+    std::vector<char> succeeded(nbChunks, 0);
+    OSD_Parallel::For(0, nbChunks, [&](int c) {
+        chunks[c].reset(new ChunkLexer(bounds[c], bounds[c + 1]));
+        chunks[c]->reserve(size_t(bounds[c + 1] - bounds[c]));
+        succeeded[c] = chunks[c]->run(false) ? 1 : 0;
+    }, m_threadCount == 1);
+    file.unmap(mapped);
+    m_stats.lexMs = timer.restart();
+
+    qint64 nbRecords = qint64(header->records().size());
+    qint64 nbParams = qint64(header->params().size());
+    for (int c = 0; c < nbChunks; ++c) {
+        if (!succeeded[c]) {
+            qWarning() << "StepParser::read() - 第" << (c + 1) << "块分析失败:" << chunks[c]->error()
+                       << "偏移:" << qint64(chunks[c]->position() - data);
+            return false;
+        }
+        nbRecords += qint64(chunks[c]->records().size());
+        nbParams += qint64(chunks[c]->params().size());
+    }
+    if (nbRecords > INT_MAX || nbParams > INT_MAX) {
+        qWarning() << "StepParser::read() - 记录数超出上限:" << nbRecords;
+        return false;
+    }
+    m_stats.nbRecords = int(nbRecords);
+    m_stats.nbParams = nbParams;
+
+    Handle(StepData_Protocol) protocol = Handle(StepData_Protocol)::DownCast(reader.WS()->Protocol());
+    if (protocol.IsNull()) {
+        qWarning() << "StepParser::read() - 会话没有STEP协议";
+        return false;
+    }
+
+    try {
+        Handle(StepData_StepModel) model = new StepData_StepModel();
+        model->SetSourceCodePage(Resource_FormatType(Interface_Static::IVal("read.step.codepage")));
+
+        // 按文件顺序合并各块的记录，子列表在这里统一编号
+        Handle(StepData_StepReaderData) readerData = new StepData_StepReaderData(
+            int(header->records().size()), int(nbRecords), int(nbParams), model->SourceCodePage());
+        int num = 0;
+        int nbSubLists = 0;
+        auto merge = [&](const ChunkLexer& lexer) {
+            const std::vector<LexRecord>& records = lexer.records();
+            const std::vector<LexParam>& params = lexer.params();
+            std::vector<int> subNumbers(records.size(), 0);
+            char subText[16];
+            for (size_t i = 0; i < records.size(); ++i) {
+                const LexRecord& record = records[i];
+                ++num;
+                const char* ident = THE_ZERO_IDENT;
+                if (record.sub) {
+                    subNumbers[i] = ++nbSubLists;
+                    std::snprintf(subText, sizeof(subText), "$%d", subNumbers[i]);
+                    ident = subText;
+                } else if (record.ident != THE_NO_TEXT) {
+                    ident = lexer.text(record.ident);
+                }
+                const char* type = record.type == THE_NO_TEXT ? THE_SUBLIST_TYPE : lexer.text(record.type);
+                readerData->SetRecord(num, ident, type, record.nbParams);
+
+                for (int p = 0; p < record.nbParams; ++p) {
+                    const LexParam& param = params[record.firstParam + p];
+                    if (param.type == Interface_ParamSub) {
+                        std::snprintf(subText, sizeof(subText), "$%d", subNumbers[param.value]);
+                        readerData->AddStepParam(num, subText, Interface_ParamSub);
+                    } else {
+                        readerData->AddStepParam(num, lexer.text(param.value), param.type);
+                    }
+                }
+                readerData->InitParams(num);
+            }
+        };
+        merge(*header);
+        header.reset();
+        for (std::unique_ptr<ChunkLexer>& chunk : chunks) {
+            merge(*chunk);
+            chunk.reset();
+        }
+        m_stats.mergeMs = timer.restart();
+
+        // 实体识别和装入模型沿用OCCT的流程（协议中的识别器）
+        StepData_StepReaderTool readerTool(readerData, protocol);
+        readerTool.SetErrorHandle(Standard_True);
+        readerTool.PrepareHeader(Handle(StepData_FileRecognizer)());
+        readerTool.Prepare(Handle(StepData_FileRecognizer)());
+        readerTool.LoadModel(model);
+        if (model->Protocol().IsNull()) {
+            model->SetProtocol(protocol);
+        }
+
+        reader.WS()->SetModel(model);
+        reader.WS()->SetLoadedFile(filename.toStdString().c_str());
+        reader.WS()->InitTransferReader(4);
+        m_stats.loadMs = timer.elapsed();
+    } catch (const Standard_Failure& e) {
+        qWarning() << "StepParser::read() - OpenCascade异常:" << e.GetMessageString();
+        return false;
+    }
+
+    qDebug() << "StepParser::read() -" << filename << "大小(MB):" << fileSize / (1024 * 1024)
+             << "分块:" << m_stats.nbChunks << "记录:" << m_stats.nbRecords << "参数:" << m_stats.nbParams
+             << "分析(ms):" << m_stats.lexMs << "合并(ms):" << m_stats.mergeMs << "装入(ms):" << m_stats.loadMs;
+    return true;
+}
+
+bool StepParser::benchmark(const QString& filename, int threadCount)
+{
+    const qint64 fileSize = QFileInfo(filename).size();
+    qDebug() << "StepParser::benchmark() -" << filename << "大小(MB):" << fileSize / (1024 * 1024);
+    if (fileSize < qint64(100) * 1024 * 1024) {
+        qDebug() << "StepParser::benchmark() - 文件小于100MB，分块收益有限，结果仅供参考";
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    STEPControl_Reader stockReader;
+    if (stockReader.ReadFile(filename.toStdString().c_str()) != IFSelect_RetDone) {
+        qWarning() << "StepParser::benchmark() - 标准解析失败:" << filename;
+        return false;
+    }
+    const qint64 stockMs = timer.restart();
+
+    STEPControl_Reader parallelReader;
+    StepParser parser(threadCount);
+    if (!parser.read(filename, parallelReader)) {
+        qWarning() << "StepParser::benchmark() - 并行解析失败:" << filename;
+        return false;
+    }
+    const qint64 parallelMs = timer.elapsed();
+
+    // 两种前端都按文件顺序编号实体，逐个比较类型
+    Handle(Interface_InterfaceModel) stockModel = stockReader.Model();
+    Handle(Interface_InterfaceModel) parallelModel = parallelReader.Model();
+    const Standard_Integer nbEntities = stockModel->NbEntities();
+    int nbMismatches = 0;
+    if (parallelModel->NbEntities() == nbEntities) {
+        for (Standard_Integer i = 1; i <= nbEntities; ++i) {
+            if (stockModel->Value(i)->DynamicType() != parallelModel->Value(i)->DynamicType()) {
+                ++nbMismatches;
+            }
+        }
+    }
+    const bool identical = parallelModel->NbEntities() == nbEntities && nbMismatches == 0;
+
+    const Statistics& stats = parser.statistics();
+    qDebug() << "StepParser::benchmark() - 标准解析(ms):" << stockMs << "并行解析(ms):" << parallelMs
+             << "加速比:" << (parallelMs > 0 ? double(stockMs) / double(parallelMs) : 0.0);
+    qDebug() << "StepParser::benchmark() - 分块:" << stats.nbChunks << "分析(ms):" << stats.lexMs
+             << "合并(ms):" << stats.mergeMs << "装入(ms):" << stats.loadMs;
+    qDebug() << "StepParser::benchmark() - 实体数:" << nbEntities << "/" << parallelModel->NbEntities()
+             << "类型不一致:" << nbMismatches << (identical ? "结果一致" : "结果不一致");
+    return identical;
+}
@@ -0,0 +1,398 @@
+﻿#include "StlReader.h"
+#include "FileIO.h"
+#include <OSD_Parallel.hxx>
+#include <Poly_Triangle.hxx>
+#include <gp_Pnt.hxx>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// 二进制STL：80字节文件头 + 4字节三角形数，每个三角形50字节（法线、三个顶点、属性）
+const qint64 THE_BINARY_HEADER_SIZE = 84;
+const qint64 THE_BINARY_TRIANGLE_SIZE = 50;
+
+// 每个块的最小三角形数，避免小文件被切得过碎
+const int THE_MIN_CHUNK_TRIANGLES = 1 << 16;
+
+// 流式读取时每次读入的字节数
+const qint64 THE_STREAM_BLOCK = 4 * 1024 * 1024;
+
+// 顶点坐标的位模式，按完全相同的坐标焊接（STL中共享顶点的坐标是逐位重复的）
+struct StlKey
+{
+    uint32_t xyz[3];
+
+    bool operator==(const StlKey& other) const
+    {
+        return xyz[0] == other.xyz[0] && xyz[1] == other.xyz[1] && xyz[2] == other.xyz[2];
+    }
+};
+
+struct StlKeyHasher
+{
+    size_t operator()(const StlKey& key) const
+    {
+        uint64_t hash = 0x9E3779B97F4A7C15ull;
+        for (uint32_t value : key.xyz) {
+            hash ^= value;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+        }
+        return size_t(hash);
+    }
+};
+
+// 顶点数据的统一访问：二进制直接读映射内存，ASCII读解析出的浮点数组
+struct StlCornerSource
+{
+    const char* base = nullptr;
+    size_t triangleStride = 0;
+
+    StlKey key(size_t corner) const
+    {
+        StlKey result;
+        std::memcpy(result.xyz, base + corner / 3 * triangleStride + corner % 3 * 12, 12);
+        for (uint32_t& value : result.xyz) {
+            // -0.0 与 0.0 视为同一坐标
+            if (value == 0x80000000u) {
+                value = 0;
+            }
+        }
+        return result;
+    }
+};
+
+inline float keyToFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 解析ASCII STL，按顺序收集 vertex 行的坐标
+void parseAscii(const char* p, const char* end, std::vector<float>& coords)
+{
+    static const char THE_VERTEX[] = "vertex";
+    const size_t vertexLength = sizeof(THE_VERTEX) - 1;
+    while (p < end) {
+        const char* newLine = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* lineEnd = newLine != nullptr ? newLine : end;
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        if (size_t(lineEnd - p) > vertexLength && std::memcmp(p, THE_VERTEX, vertexLength) == 0) {
+            p += vertexLength;
+            for (int i = 0; i < 3; ++i) {
+                while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '+')) {
+                    ++p;
+                }
+                float value = 0.0f;
+                std::from_chars_result res = std::from_chars(p, lineEnd, value);
+                if (res.ec == std::errc()) {
+                    p = res.ptr;
+                }
+                coords.push_back(value);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+} // namespace
+
+StlReader::StlReader(int threadCount)
+    : m_threadCount(FileIO::resolveThreadCount(threadCount))
+{
+}
+
+bool StlReader::read(const QString& filename)
+{
+    m_triangulation.Nullify();
+    m_stats = Statistics();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "StlReader::read() - 无法打开文件:" << filename;
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    m_stats.fileSize = fileSize;
+    if (fileSize == 0) {
+        return false;
+    }
+
+    uchar* mapped = file.map(0, fileSize);
+    if (mapped == nullptr) {
+        qWarning() << "StlReader::read() - 内存映射失败:" << file.errorString();
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(mapped);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 识别格式：大小与三角形数吻合即为二进制（部分二进制文件头也以 "solid" 开头）
+    const bool startsWithSolid = fileSize >= 5 && std::memcmp(data, "solid", 5) == 0;
+    qint64 nbTriangles = 0;
+    bool binary = false;
+    if (fileSize >= THE_BINARY_HEADER_SIZE) {
+        quint32 count = 0;
+        std::memcpy(&count, data + 80, sizeof(count));
+        const qint64 expected = THE_BINARY_HEADER_SIZE + qint64(count) * THE_BINARY_TRIANGLE_SIZE;
+        if (expected == fileSize || !startsWithSolid) {
+            binary = true;
+            nbTriangles = std::min<qint64>(count, (fileSize - THE_BINARY_HEADER_SIZE) / THE_BINARY_TRIANGLE_SIZE);
+            if (expected != fileSize) {
+                qWarning() << "StlReader::read() - 文件大小与三角形数不符，按" << nbTriangles << "个三角形读取";
+            }
+        }
+    }
+
+    std::vector<float> asciiCoords;
+    if (binary) {
+        // 跳过每个三角形开头的法线
+        m_triangulation = weld(data + THE_BINARY_HEADER_SIZE + 12, size_t(THE_BINARY_TRIANGLE_SIZE), nbTriangles, timer);
+    } else if (startsWithSolid) {
+        parseAscii(data, data + fileSize, asciiCoords);
+        m_triangulation = weld(reinterpret_cast<const char*>(asciiCoords.data()), 9 * sizeof(float),
+                               qint64(asciiCoords.size() / 9), timer);
+    } else {
+        qWarning() << "StlReader::read() - 无法识别的STL文件:" << filename;
+    }
+    m_stats.binary = binary;
+
+    file.unmap(mapped);
+    file.close();
+    logStatistics(filename);
+    return !m_triangulation.IsNull();
+}
+
+bool StlReader::read(QIODevice& device, const QString& name)
+{
+    m_triangulation.Nullify();
+    m_stats = Statistics();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 顺序读取，无法用文件大小校验：以 "solid" 开头且前几行出现 facet 时按ASCII处理
+    const QByteArray head = device.peek(1024);
+    const bool ascii = head.startsWith("solid") && (head.contains("facet") || head.contains("endsolid"));
+    m_stats.binary = !ascii;
+
+    // 顶点坐标按三角形连续存放（每个三角形9个float），二进制记录中的法线和属性被丢弃
+    std::vector<float> coords;
+    std::vector<char> block(size_t(THE_STREAM_BLOCK));
+    if (ascii) {
+        // 按行边界切块解析，不完整的末行留到下一块
+        size_t pending = 0;
+        for (;;) {
+            const qint64 count = device.read(block.data() + pending, qint64(block.size() - pending));
+            const size_t filled = pending + size_t(std::max<qint64>(count, 0));
+            m_stats.fileSize += std::max<qint64>(count, 0);
+            if (count <= 0) {
+                parseAscii(block.data(), block.data() + filled, coords);
+                break;
+            }
+            const char* lastNewLine = nullptr;
+            for (const char* p = block.data() + filled; p > block.data(); --p) {
+                if (p[-1] == '\n') {
+                    lastNewLine = p - 1;
+                    break;
+                }
+            }
+            if (lastNewLine == nullptr) {
+                // 单行超过块大小：扩大缓冲区
+                pending = filled;
+                if (pending == block.size()) {
+                    block.resize(block.size() * 2);
+                }
+                continue;
+            }
+            parseAscii(block.data(), lastNewLine + 1, coords);
+            pending = size_t(block.data() + filled - (lastNewLine + 1));
+            std::memmove(block.data(), lastNewLine + 1, pending);
+        }
+    } else {
+        char header[THE_BINARY_HEADER_SIZE];
+        if (device.read(header, THE_BINARY_HEADER_SIZE) != THE_BINARY_HEADER_SIZE) {
+            qWarning() << "StlReader::read() - STL文件头不完整:" << name;
+            return false;
+        }
+        quint32 declared = 0;
+        std::memcpy(&declared, header + 80, sizeof(declared));
+        coords.reserve(size_t(std::min<quint32>(declared, 1u << 26)) * 9);
+        m_stats.fileSize = THE_BINARY_HEADER_SIZE;
+
+        // 每块读入整数个三角形记录
+        const qint64 recordsPerBlock = THE_STREAM_BLOCK / THE_BINARY_TRIANGLE_SIZE;
+        const qint64 blockBytes = recordsPerBlock * THE_BINARY_TRIANGLE_SIZE;
+        qint64 filled = 0;
+        for (;;) {
+            const qint64 count = device.read(block.data() + filled, blockBytes - filled);
+            if (count > 0) {
+                filled += count;
+                m_stats.fileSize += count;
+                if (filled < blockBytes) {
+                    continue;
+                }
+            }
+            const qint64 nbRecords = filled / THE_BINARY_TRIANGLE_SIZE;
+            const size_t offset = coords.size();
+            coords.resize(offset + size_t(nbRecords) * 9);
+            for (qint64 r = 0; r < nbRecords; ++r) {
+                std::memcpy(&coords[offset + size_t(r) * 9], block.data() + r * THE_BINARY_TRIANGLE_SIZE + 12,
+                            9 * sizeof(float));
+            }
+            if (count <= 0) {
+                break;
+            }
+            filled = 0;
+        }
+        if (qint64(coords.size() / 9) != qint64(declared)) {
+            qWarning() << "StlReader::read() - 数据中的三角形数与文件头不符:" << coords.size() / 9 << "/" << declared;
+        }
+    }
+    std::vector<char>().swap(block);
+
+    m_triangulation = weld(reinterpret_cast<const char*>(coords.data()), 9 * sizeof(float),
+                           qint64(coords.size() / 9), timer);
+    logStatistics(name);
+    return !m_triangulation.IsNull();
+}
+
+Handle(Poly_Triangulation) StlReader::weld(const char* base, size_t triangleStride, qint64 nbTriangles,
+                                           QElapsedTimer& timer)
+{
+    m_stats.parseMs = timer.restart();
+    if (nbTriangles == 0 || nbTriangles > INT_MAX / 3) {
+        qWarning() << "StlReader::read() - 三角形数无效:" << nbTriangles;
+        return Handle(Poly_Triangulation)();
+    }
+
+    StlCornerSource source;
+    source.base = base;
+    source.triangleStride = triangleStride;
+
+    // 第一遍：按块计算每个角点的哈希分区，分区内保持块顺序，线程数相同时顶点编号确定
+    const int nbPartitions = m_threadCount;
+    const int nbChunks = int(std::max<qint64>(1, std::min<qint64>(m_threadCount * 4, nbTriangles / THE_MIN_CHUNK_TRIANGLES)));
+    const size_t nbCorners = size_t(nbTriangles) * 3;
+    std::vector<std::vector<std::vector<int>>> buckets(nbChunks, std::vector<std::vector<int>>(nbPartitions));
+    OSD_Parallel::For(0, nbChunks, [&](int c) {
+        const size_t begin = nbCorners / 3 * c / nbChunks * 3;
+        const size_t end = nbCorners / 3 * (c + 1) / nbChunks * 3;
+        std::vector<std::vector<int>>& chunkBuckets = buckets[c];
+        for (std::vector<int>& bucket : chunkBuckets) {
+            bucket.reserve((end - begin) / nbPartitions + 16);
+        }
+        StlKeyHasher hasher;
+        for (size_t corner = begin; corner < end; ++corner) {
+            const size_t hash = hasher(source.key(corner));
+            chunkBuckets[(hash >> (sizeof(size_t) * 4)) % size_t(nbPartitions)].push_back(int(corner));
+        }
+    }, m_threadCount == 1);
+    m_stats.parseMs += timer.restart();
+
+    // 第二遍：每个分区独立焊接，分配分区内的顶点编号
+    std::vector<int> cornerNodes(nbCorners);
+    std::vector<std::vector<float>> partitionCoords(nbPartitions);
+    OSD_Parallel::For(0, nbPartitions, [&](int p) {
+        size_t nbPartitionCorners = 0;
+        for (int c = 0; c < nbChunks; ++c) {
+            nbPartitionCorners += buckets[c][p].size();
+        }
+        std::unordered_map<StlKey, int, StlKeyHasher> nodes;
+        nodes.reserve(nbPartitionCorners / 4 + 16);
+        std::vector<float>& coords = partitionCoords[p];
+        for (int c = 0; c < nbChunks; ++c) {
+            for (int corner : buckets[c][p]) {
+                const StlKey key = source.key(size_t(corner));
+                auto inserted = nodes.emplace(key, int(coords.size() / 3));
+                if (inserted.second) {
+                    coords.push_back(keyToFloat(key.xyz[0]));
+                    coords.push_back(keyToFloat(key.xyz[1]));
+                    coords.push_back(keyToFloat(key.xyz[2]));
+                }
+                cornerNodes[size_t(corner)] = inserted.first->second;
+            }
+        }
+    }, m_threadCount == 1);
+    m_stats.weldMs = timer.restart();
+
+    std::vector<int> partitionOffsets(nbPartitions);
+    qint64 nbNodes = 0;
+    for (int p = 0; p < nbPartitions; ++p) {
+        partitionOffsets[p] = int(nbNodes);
+        nbNodes += qint64(partitionCoords[p].size() / 3);
+    }
+
+    // 第三遍：填充单精度三角网格
+    Handle(Poly_Triangulation) triangulation = new Poly_Triangulation();
+    triangulation->SetDoublePrecision(false);
+    triangulation->ResizeNodes(int(nbNodes), false);
+    triangulation->ResizeTriangles(int(nbTriangles), false);
+
+    OSD_Parallel::For(0, nbPartitions, [&](int p) {
+        const int offset = partitionOffsets[p];
+        std::vector<float>& coords = partitionCoords[p];
+        const int nbPartitionNodes = int(coords.size() / 3);
+        for (int i = 0; i < nbPartitionNodes; ++i) {
+            const float* xyz = &coords[size_t(i) * 3];
+            triangulation->SetNode(offset + i + 1, gp_Pnt(xyz[0], xyz[1], xyz[2]));
+        }
+        std::vector<float>().swap(coords);
+        for (int c = 0; c < nbChunks; ++c) {
+            for (int corner : buckets[c][p]) {
+                cornerNodes[size_t(corner)] += offset + 1;
+            }
+            std::vector<int>().swap(buckets[c][p]);
+        }
+    }, m_threadCount == 1);
+
+    std::vector<int> degenerate(nbChunks, 0);
+    OSD_Parallel::For(0, nbChunks, [&](int c) {
+        const int begin = int(nbTriangles * c / nbChunks);
+        const int end = int(nbTriangles * (c + 1) / nbChunks);
+        for (int t = begin; t < end; ++t) {
+            const int n1 = cornerNodes[size_t(t) * 3];
+            const int n2 = cornerNodes[size_t(t) * 3 + 1];
+            const int n3 = cornerNodes[size_t(t) * 3 + 2];
+            if (n1 == n2 || n2 == n3 || n1 == n3) {
+                ++degenerate[c];
+            }
+            triangulation->SetTriangle(t + 1, Poly_Triangle(n1, n2, n3));
+        }
+    }, m_threadCount == 1);
+    m_stats.buildMs = timer.elapsed();
+
+
+    for (int count : degenerate) {
+        m_stats.nbDegenerate += count;
+    }
+    m_stats.nbTriangles = int(nbTriangles);
+    m_stats.nbNodes = int(nbNodes);
+    m_stats.nbPartitions = nbPartitions;
+    return triangulation;
+}
+
+void StlReader::logStatistics(const QString& filename) const
+{
+    if (m_stats.nbTriangles == 0) {
+        return;
+    }
+    qDebug() << "StlReader::read() -" << filename << (m_stats.binary ? "二进制" : "ASCII")
+             << "三角形:" << m_stats.nbTriangles << "焊接后顶点:" << m_stats.nbNodes
+             << "(原始角点:" << qint64(m_stats.nbTriangles) * 3 << ")" << "退化三角形:" << m_stats.nbDegenerate
+             << "解析(ms):" << m_stats.parseMs << "焊接(ms):" << m_stats.weldMs << "构建(ms):" << m_stats.buildMs;
+}
@@ -0,0 +1,184 @@
+﻿#include "StlWriter.h"
+#include "FileIO.h"
+#include <OSD_Parallel.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Vec.hxx>
+#include <gp.hxx>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// 二进制STL：80字节文件头 + 4字节三角形数，每个三角形50字节（法线、三个顶点、属性）
+const qint64 THE_HEADER_SIZE = 84;
+const qint64 THE_TRIANGLE_SIZE = 50;
+
+struct StlFaceJob
+{
+    Handle(Poly_Triangulation) triangulation;
+    gp_Trsf trsf;
+    bool reversed = false;
+    qint64 offset = 0;          // 在文件中的字节偏移
+};
+
+inline char* putFloat(char* out, double value)
+{
+    const float single = float(value);
+    std::memcpy(out, &single, sizeof(single));
+    return out + sizeof(single);
+}
+
+void fillFace(const StlFaceJob& job, char* out)
+{
+    const Handle(Poly_Triangulation)& triangulation = job.triangulation;
+    const int nbTriangles = triangulation->NbTriangles();
+    for (int t = 1; t <= nbTriangles; ++t) {
+        Standard_Integer nodes[3];
+        triangulation->Triangle(t).Get(nodes[0], nodes[1], nodes[2]);
+        if (job.reversed) {
+            std::swap(nodes[1], nodes[2]);
+        }
+        gp_Pnt points[3];
+        for (int k = 0; k < 3; ++k) {
+            points[k] = triangulation->Node(nodes[k]).Transformed(job.trsf);
+        }
+        gp_Vec normal = gp_Vec(points[0], points[1]).Crossed(gp_Vec(points[0], points[2]));
+        const double magnitude = normal.Magnitude();
+        if (magnitude > gp::Resolution()) {
+            normal /= magnitude;
+        } else {
+            normal = gp_Vec(0.0, 0.0, 0.0);
+        }
+
+        out = putFloat(out, normal.X());
+        out = putFloat(out, normal.Y());
+        out = putFloat(out, normal.Z());
+        for (const gp_Pnt& point : points) {
+            out = putFloat(out, point.X());
+            out = putFloat(out, point.Y());
+            out = putFloat(out, point.Z());
+        }
+        // 属性字节数
+        out[0] = 0;
+        out[1] = 0;
+        out += 2;
+    }
+}
+
+} // namespace
+
+StlWriter::StlWriter()
+    : m_linearDeflection(0.1)
+    , m_angularDeflection(0.5)
+    , m_threadCount(0)
+{
+}
+
+bool StlWriter::write(const QString& filename, const TopoDS_Shape& shape)
+{
+    m_stats = Statistics();
+    if (shape.IsNull()) {
+        return false;
+    }
+
+    const bool singleThread = FileIO::resolveThreadCount(m_threadCount) == 1;
+
+    // 剖分（BRepMesh 内部按面并行），已有满足精度的三角网格会被保留
+    QElapsedTimer timer;
+    timer.start();
+    BRepMesh_IncrementalMesh mesher(shape, m_linearDeflection, Standard_False, m_angularDeflection, !singleThread);
+
+    // 收集面并计算每个面在文件中的偏移
+    std::vector<StlFaceJob> jobs;
+    qint64 offset = THE_HEADER_SIZE;
+    for (TopExp_Explorer explorer(shape, TopAbs_FACE); explorer.More(); explorer.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(explorer.Current());
+        TopLoc_Location location;
+        Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(face, location);
+        if (triangulation.IsNull() || triangulation->NbTriangles() == 0) {
+            continue;
+        }
+        StlFaceJob job;
+        job.triangulation = triangulation;
+        job.trsf = location.Transformation();
+        const bool mirrored = job.trsf.VectorialPart().Determinant() < 0.0;
+        job.reversed = (face.Orientation() == TopAbs_REVERSED) != mirrored;
+        job.offset = offset;
+        offset += triangulation->NbTriangles() * THE_TRIANGLE_SIZE;
+        m_stats.nbTriangles += triangulation->NbTriangles();
+        jobs.push_back(job);
+    }
+    m_stats.nbFaces = int(jobs.size());
+    m_stats.meshMs = timer.restart();
+
+    if (jobs.empty()) {
+        qWarning() << "StlWriter::write() - 没有可导出的三角网格";
+        return false;
+    }
+    if (m_stats.nbTriangles > qint64(0xFFFFFFFFu)) {
+        qWarning() << "StlWriter::write() - 三角形数超出二进制STL上限:" << m_stats.nbTriangles;
+        return false;
+    }
+
+    const qint64 fileSize = offset;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "StlWriter::write() - 无法写入文件:" << filename;
+        return false;
+    }
+
+    // 优先直接填充映射的输出文件；映射失败时退回内存缓冲区
+    std::vector<char> buffer;
+    char* out = nullptr;
+    uchar* mapped = nullptr;
+    if (file.resize(fileSize)) {
+        mapped = file.map(0, fileSize);
+    }
+    if (mapped != nullptr) {
+        out = reinterpret_cast<char*>(mapped);
+        m_stats.mapped = true;
+    } else {
+        buffer.resize(size_t(fileSize));
+        out = buffer.data();
+    }
+
+    char header[80];
+    std::memset(header, 0, sizeof(header));
+    const char title[] = "MyCad binary STL export";
+    std::memcpy(header, title, sizeof(title) - 1);
+    std::memcpy(out, header, sizeof(header));
+    const quint32 count = quint32(m_stats.nbTriangles);
+    std::memcpy(out + 80, &count, sizeof(count));
+
+    OSD_Parallel::For(0, int(jobs.size()), [&jobs, out](int i) {
+        fillFace(jobs[i], out + jobs[i].offset);
+    }, singleThread);
+
+    bool ok = true;
+    if (mapped != nullptr) {
+        ok = file.unmap(mapped);
+    } else {
+        file.seek(0);
+        ok = file.write(buffer.data(), fileSize) == fileSize;
+    }
+    file.close();
+    m_stats.bytesWritten = fileSize;
+    m_stats.writeMs = timer.elapsed();
+
+    qDebug() << "StlWriter::write() -" << filename
+             << "面:" << m_stats.nbFaces << "三角形:" << m_stats.nbTriangles
+             << "大小(MB):" << fileSize / (1024 * 1024) << (m_stats.mapped ? "映射写入" : "缓冲写入")
+             << "剖分(ms):" << m_stats.meshMs << "填充与写出(ms):" << m_stats.writeMs;
+    return ok;
+}
@@ -2,7 +2,6 @@
 #include "Document.h"
 #include "Modeling.h"
 #include <QMessageBox>
-#include <algorithm>
 
 TransformManager::TransformManager(QObject* parent)
     : QObject(parent)
@@ -22,7 +21,7 @@ bool TransformManager::booleanUnion(const QList<TopoDS_Shape>& shapes, const QLi
     }
     
     if (!result.IsNull()) {
-        // 移除原始形状（从后往前移除，避免索引变化）
+        // 移除原始形状并添加结果，只刷新一次视图
         QList<int> indicesToRemove;
         for (const auto& aisShape : aisShapes) {
             int index = m_document->findShapeIndex(aisShape);
@@ -30,16 +29,10 @@ bool TransformManager::booleanUnion(const QList<TopoDS_Shape>& shapes, const QLi
                 indicesToRemove.append(index);
             }
         }
-        // 排序并去重，从大到小排序以便从后往前移除
-        std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
-        indicesToRemove.erase(std::unique(indicesToRemove.begin(), indicesToRemove.end()), indicesToRemove.end());
-        
-        for (int index : indicesToRemove) {
-            m_document->removeShape(index);
-        }
-        
-        // 添加结果
+        m_document->beginUpdate();
+        m_document->removeShapes(indicesToRemove);
         m_document->addShape(result, "Union");
+        m_document->endUpdate();
         emit transformCompleted();
         return true;
     }
@@ -59,7 +52,7 @@ bool TransformManager::booleanCut(const QList<TopoDS_Shape>& shapes, const QList
     }
     
     if (!result.IsNull()) {
-        // 移除原始形状
+        // 移除原始形状并添加结果，只刷新一次视图
         QList<int> indicesToRemove;
         for (const auto& aisShape : aisShapes) {
             int index = m_document->findShapeIndex(aisShape);
@@ -67,14 +60,10 @@ bool TransformManager::booleanCut(const QList<TopoDS_Shape>& shapes, const QList
                 indicesToRemove.append(index);
             }
         }
-        std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
-        indicesToRemove.erase(std::unique(indicesToRemove.begin(), indicesToRemove.end()), indicesToRemove.end());
-        
-        for (int index : indicesToRemove) {
-            m_document->removeShape(index);
-        }
-        
+        m_document->beginUpdate();
+        m_document->removeShapes(indicesToRemove);
         m_document->addShape(result, "Cut");
+        m_document->endUpdate();
         emit transformCompleted();
         return true;
     }
@@ -94,7 +83,7 @@ bool TransformManager::booleanIntersect(const QList<TopoDS_Shape>& shapes, const
     }
     
     if (!result.IsNull()) {
-        // 移除原始形状
+        // 移除原始形状并添加结果，只刷新一次视图
         QList<int> indicesToRemove;
         for (const auto& aisShape : aisShapes) {
             int index = m_document->findShapeIndex(aisShape);
@@ -102,14 +91,10 @@ bool TransformManager::booleanIntersect(const QList<TopoDS_Shape>& shapes, const
                 indicesToRemove.append(index);
             }
         }
-        std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
-        indicesToRemove.erase(std::unique(indicesToRemove.begin(), indicesToRemove.end()), indicesToRemove.end());
-        
-        for (int index : indicesToRemove) {
-            m_document->removeShape(index);
-        }
-        
+        m_document->beginUpdate();
+        m_document->removeShapes(indicesToRemove);
         m_document->addShape(result, "Intersect");
+        m_document->endUpdate();
         emit transformCompleted();
         return true;
     }
@@ -124,6 +109,7 @@ bool TransformManager::translate(const QList<TopoDS_Shape>& shapes, const gp_Vec
     }
     
     bool success = false;
+    m_document->beginUpdate();
     for (const auto& shape : shapes) {
         TopoDS_Shape translated = Modeling::translate(shape, vec);
         if (!translated.IsNull()) {
@@ -131,6 +117,7 @@ bool TransformManager::translate(const QList<TopoDS_Shape>& shapes, const gp_Vec
             success = true;
         }
     }
+    m_document->endUpdate();
     
     if (success) {
         emit transformCompleted();
@@ -146,6 +133,7 @@ bool TransformManager::rotate(const QList<TopoDS_Shape>& shapes, const gp_Ax1& a
     }
     
     bool success = false;
+    m_document->beginUpdate();
     for (const auto& shape : shapes) {
         TopoDS_Shape rotated = Modeling::rotate(shape, axis, angle);
         if (!rotated.IsNull()) {
@@ -153,6 +141,7 @@ bool TransformManager::rotate(const QList<TopoDS_Shape>& shapes, const gp_Ax1& a
             success = true;
         }
     }
+    m_document->endUpdate();
     
     if (success) {
         emit transformCompleted();
@@ -168,6 +157,7 @@ bool TransformManager::mirror(const QList<TopoDS_Shape>& shapes, const gp_Ax2& a
     }
     
     bool success = false;
+    m_document->beginUpdate();
     for (const auto& shape : shapes) {
         TopoDS_Shape mirrored = Modeling::mirror(shape, axis);
         if (!mirrored.IsNull()) {
@@ -175,6 +165,7 @@ bool TransformManager::mirror(const QList<TopoDS_Shape>& shapes, const gp_Ax2& a
             success = true;
         }
     }
+    m_document->endUpdate();
     
     if (success) {
         emit transformCompleted();
@@ -191,9 +182,12 @@ bool TransformManager::linearArray(const TopoDS_Shape& shape, const gp_Vec& dire
     
     QList<TopoDS_Shape> array = Modeling::linearArray(shape, direction, count, spacing);
     
-    for (const auto& s : array) {
-        m_document->addShape(s, "ArrayItem");
+    // 整个阵列一次加入文档，只刷新一次视图
+    QStringList names;
+    for (int i = 0; i < array.size(); ++i) {
+        names.append("ArrayItem");
     }
+    m_document->addShapes(array, names);
     
     emit transformCompleted();
     return true;
@@ -207,9 +201,12 @@ bool TransformManager::circularArray(const TopoDS_Shape& shape, const gp_Pnt& ce
     
     QList<TopoDS_Shape> array = Modeling::circularArray(shape, center, axis, count, angle);
     
-    for (const auto& s : array) {
-        m_document->addShape(s, "ArrayItem");
+    // 整个阵列一次加入文档，只刷新一次视图
+    QStringList names;
+    for (int i = 0; i < array.size(); ++i) {
+        names.append("ArrayItem");
     }
+    m_document->addShapes(array, names);
     
     emit transformCompleted();
     return true;
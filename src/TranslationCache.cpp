@@ -0,0 +1,191 @@
+﻿#include "TranslationCache.h"
+#include "FileIO.h"
+#include <BinTools.hxx>
+#include <Standard_Failure.hxx>
+#include <Standard_Version.hxx>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+
+// 缓存条目格式版本，格式或转换逻辑变化时递增，使旧条目自动失效
+const int THE_CACHE_VERSION = 1;
+const char* const THE_ENTRY_SUFFIX = ".bbrep";
+
+} // namespace
+
+TranslationCache& TranslationCache::instance()
+{
+    static TranslationCache cache;
+    return cache;
+}
+
+TranslationCache::TranslationCache()
+    : m_directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/translation")
+    , m_enabled(true)
+    , m_maxBytes(qint64(2) * 1024 * 1024 * 1024)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+void TranslationCache::setDirectory(const QString& directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_directory = directory;
+}
+
+QString TranslationCache::directory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directory;
+}
+
+QString TranslationCache::entryPath(const QByteArray& key) const
+{
+    return directory() + "/" + QString::fromLatin1(key) + THE_ENTRY_SUFFIX;
+}
+
+QByteArray TranslationCache::key(const QString& filename, const ImportOptions& options) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    // 文件内容 + 影响转换结果的设置 + OCCT版本
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    const QString settings = QString("v%1|%2|roots=%3|stlMesh=%4|sew=%5|occt=%6")
+        .arg(THE_CACHE_VERSION)
+        .arg(QFileInfo(filename).suffix().toLower())
+        .arg(options.stepAllRoots ? 1 : 0)
+        .arg(options.stlMeshOnly ? 1 : 0)
+        .arg(options.igesSewingTolerance)
+        .arg(OCC_VERSION_COMPLETE);
+    hash.addData(settings.toUtf8());
+    return hash.result().toHex();
+}
+
+bool TranslationCache::lookup(const QByteArray& key, TopoDS_Shape& shape)
+{
+    if (!m_enabled || key.isEmpty()) {
+        return false;
+    }
+
+    const QString path = entryPath(key);
+    if (!QFile::exists(path)) {
+        ++m_misses;
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = false;
+    try {
+        ok = BinTools::Read(shape, path.toLocal8Bit().constData()) && !shape.IsNull();
+    } catch (const Standard_Failure& e) {
+        qWarning() << "TranslationCache::lookup() - 读取缓存异常:" << e.GetMessageString();
+    }
+    if (!ok) {
+        // 损坏的条目直接删除
+        QFile::remove(path);
+        shape.Nullify();
+        ++m_misses;
+        return false;
+    }
+
+    // 更新修改时间作为最近使用时间
+    QFile entry(path);
+    if (entry.open(QIODevice::ReadWrite)) {
+        entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+
+    ++m_hits;
+    qDebug() << "TranslationCache::lookup() - 命中:" << key << "读取(ms):" << timer.elapsed()
+             << "命中/未命中:" << hits() << "/" << misses();
+    return true;
+}
+
+bool TranslationCache::store(const QByteArray& key, const TopoDS_Shape& shape)
+{
+    if (!m_enabled || key.isEmpty() || shape.IsNull()) {
+        return false;
+    }
+
+    const QString dir = directory();
+    if (!QDir().mkpath(dir)) {
+        qWarning() << "TranslationCache::store() - 无法创建缓存目录:" << dir;
+        return false;
+    }
+
+    // 先写临时文件再改名，避免其他线程读到写了一半的条目
+    const QString path = entryPath(key);
+    const QString tempPath = path + "." + QString::number(quintptr(QThread::currentThreadId())) + ".tmp";
+    bool ok = false;
+    try {
+        ok = BinTools::Write(shape, tempPath.toLocal8Bit().constData());
+    } catch (const Standard_Failure& e) {
+        qWarning() << "TranslationCache::store() - 写入缓存异常:" << e.GetMessageString();
+    }
+    if (!ok) {
+        QFile::remove(tempPath);
+        return false;
+    }
+    if (!QFile::rename(tempPath, path)) {
+        // 其他线程已写入同一条目
+        QFile::remove(tempPath);
+    }
+
+    evict();
+    return true;
+}
+
+void TranslationCache::evict()
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 按修改时间从旧到新，删除最久未使用的条目直到总大小不超过上限
+    QDir dir(m_directory);
+    const QFileInfoList entries = dir.entryInfoList(QStringList() << QString("*") + THE_ENTRY_SUFFIX,
+                                                    QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo& entry : entries) {
+        total += entry.size();
+    }
+    int nbRemoved = 0;
+    for (const QFileInfo& entry : entries) {
+        if (total <= m_maxBytes) {
+            break;
+        }
+        if (QFile::remove(entry.absoluteFilePath())) {
+            total -= entry.size();
+            ++nbRemoved;
+        }
+    }
+    if (nbRemoved > 0) {
+        qDebug() << "TranslationCache::evict() - 淘汰条目:" << nbRemoved << "剩余(MB):" << total / (1024 * 1024);
+    }
+}
+
+void TranslationCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QDir dir(m_directory);
+    const QFileInfoList entries = dir.entryInfoList(QStringList() << QString("*") + THE_ENTRY_SUFFIX, QDir::Files);
+    for (const QFileInfo& entry : entries) {
+        QFile::remove(entry.absoluteFilePath());
+    }
+    m_hits = 0;
+    m_misses = 0;
+}
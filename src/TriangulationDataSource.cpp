@@ -0,0 +1,120 @@
+﻿#include "TriangulationDataSource.h"
+#include <Poly_Triangle.hxx>
+#include <TColStd_Array1OfReal.hxx>
+#include <TColStd_Array1OfInteger.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Vec.hxx>
+
+TriangulationDataSource::TriangulationDataSource(const Handle(Poly_Triangulation)& triangulation)
+    : m_triangulation(triangulation)
+{
+    if (m_triangulation.IsNull()) {
+        return;
+    }
+    for (Standard_Integer i = 1; i <= m_triangulation->NbNodes(); ++i) {
+        m_nodes.Add(i);
+    }
+    for (Standard_Integer i = 1; i <= m_triangulation->NbTriangles(); ++i) {
+        m_elements.Add(i);
+    }
+}
+
+Standard_Boolean TriangulationDataSource::GetGeom(const Standard_Integer ID, const Standard_Boolean IsElement,
+                                                  TColStd_Array1OfReal& Coords, Standard_Integer& NbNodes,
+                                                  MeshVS_EntityType& Type) const
+{
+    if (m_triangulation.IsNull()) {
+        return Standard_False;
+    }
+
+    if (IsElement) {
+        if (ID < 1 || ID > m_triangulation->NbTriangles() || Coords.Length() < 9) {
+            return Standard_False;
+        }
+        Standard_Integer nodes[3];
+        m_triangulation->Triangle(ID).Get(nodes[0], nodes[1], nodes[2]);
+        Standard_Integer index = Coords.Lower();
+        for (Standard_Integer node : nodes) {
+            const gp_Pnt point = m_triangulation->Node(node);
+            Coords(index++) = point.X();
+            Coords(index++) = point.Y();
+            Coords(index++) = point.Z();
+        }
+        NbNodes = 3;
+        Type = MeshVS_ET_Face;
+        return Standard_True;
+    }
+
+    if (ID < 1 || ID > m_triangulation->NbNodes() || Coords.Length() < 3) {
+        return Standard_False;
+    }
+    const gp_Pnt point = m_triangulation->Node(ID);
+    Coords(Coords.Lower()) = point.X();
+    Coords(Coords.Lower() + 1) = point.Y();
+    Coords(Coords.Lower() + 2) = point.Z();
+    NbNodes = 1;
+    Type = MeshVS_ET_Node;
+    return Standard_True;
+}
+
+Standard_Boolean TriangulationDataSource::GetGeomType(const Standard_Integer ID, const Standard_Boolean IsElement,
+                                                      MeshVS_EntityType& Type) const
+{
+    if (m_triangulation.IsNull()) {
+        return Standard_False;
+    }
+    if (IsElement) {
+        if (ID < 1 || ID > m_triangulation->NbTriangles()) {
+            return Standard_False;
+        }
+        Type = MeshVS_ET_Face;
+        return Standard_True;
+    }
+    if (ID < 1 || ID > m_triangulation->NbNodes()) {
+        return Standard_False;
+    }
+    Type = MeshVS_ET_Node;
+    return Standard_True;
+}
+
+Standard_Address TriangulationDataSource::GetAddr(const Standard_Integer /*ID*/, const Standard_Boolean /*IsElement*/) const
+{
+    return nullptr;
+}
+
+Standard_Boolean TriangulationDataSource::GetNodesByElement(const Standard_Integer ID, TColStd_Array1OfInteger& NodeIDs,
+                                                            Standard_Integer& NbNodes) const
+{
+    if (m_triangulation.IsNull() || ID < 1 || ID > m_triangulation->NbTriangles() || NodeIDs.Length() < 3) {
+        return Standard_False;
+    }
+    Standard_Integer n1, n2, n3;
+    m_triangulation->Triangle(ID).Get(n1, n2, n3);
+    NodeIDs(NodeIDs.Lower()) = n1;
+    NodeIDs(NodeIDs.Lower() + 1) = n2;
+    NodeIDs(NodeIDs.Lower() + 2) = n3;
+    NbNodes = 3;
+    return Standard_True;
+}
+
+Standard_Boolean TriangulationDataSource::GetNormal(const Standard_Integer Id, const Standard_Integer /*Max*/,
+                                                    Standard_Real& nx, Standard_Real& ny, Standard_Real& nz) const
+{
+    if (m_triangulation.IsNull() || Id < 1 || Id > m_triangulation->NbTriangles()) {
+        return Standard_False;
+    }
+
+    // 按三角形顶点计算面法线
+    Standard_Integer n1, n2, n3;
+    m_triangulation->Triangle(Id).Get(n1, n2, n3);
+    const gp_Pnt p1 = m_triangulation->Node(n1);
+    const gp_Vec normal = gp_Vec(p1, m_triangulation->Node(n2)).Crossed(gp_Vec(p1, m_triangulation->Node(n3)));
+    const Standard_Real magnitude = normal.Magnitude();
+    if (magnitude <= gp::Resolution()) {
+        return Standard_False;
+    }
+    nx = normal.X() / magnitude;
+    ny = normal.Y() / magnitude;
+    nz = normal.Z() / magnitude;
+    return Standard_True;
+}
@@ -479,6 +479,7 @@ void View3D::mouseReleaseEvent(QMouseEvent* event)
             
             m_context->UpdateCurrentViewer();
             update();
+            emit selectionChanged();
         }
         m_isSelecting = false;
     }
@@ -1018,9 +1019,9 @@ void View3D::onContextMenuShowOnly()
     
     // 隐藏所有对象
     for (int i = 0; i < m_document->getShapeCount(); ++i) {
-        Handle(AIS_Shape) shape = m_document->getAISShape(i);
-        if (!shape.IsNull()) {
-            m_context->Erase(shape, Standard_False);
+        Handle(AIS_InteractiveObject) object = m_document->getDisplayObject(i);
+        if (!object.IsNull()) {
+            m_context->Erase(object, Standard_False);
         }
     }
     
@@ -1046,9 +1047,9 @@ void View3D::onContextMenuShowAll()
     
     // 显示所有对象
     for (int i = 0; i < m_document->getShapeCount(); ++i) {
-        Handle(AIS_Shape) shape = m_document->getAISShape(i);
-        if (!shape.IsNull()) {
-            m_context->Display(shape, Standard_False);
+        Handle(AIS_InteractiveObject) object = m_document->getDisplayObject(i);
+        if (!object.IsNull()) {
+            m_context->Display(object, Standard_False);
         }
     }
     
@@ -1069,9 +1070,9 @@ void View3D::onContextMenuHideAll()
     
     // 隐藏所有对象（除了ViewCube）
     for (int i = 0; i < m_document->getShapeCount(); ++i) {
-        Handle(AIS_Shape) shape = m_document->getAISShape(i);
-        if (!shape.IsNull()) {
-            m_context->Erase(shape, Standard_False);
+        Handle(AIS_InteractiveObject) object = m_document->getDisplayObject(i);
+        if (!object.IsNull()) {
+            m_context->Erase(object, Standard_False);
         }
     }
     
@@ -1,4 +1,5 @@
 ﻿#include "MainWindow.h"
+#include "StepParser.h"
 #include <QApplication>
 #include <QStyleFactory>
 #include <QTextCodec>
@@ -120,6 +121,17 @@ int main(int argc, char *argv[])
     app.setStyle(QStyleFactory::create("Fusion"));
     qDebug() << "设置样式完成";
     
+    // 命令行性能对比：MyCad --benchmark-step a.stp b.stp ...，不创建窗口
+    const QStringList arguments = app.arguments();
+    const int benchmarkIndex = arguments.indexOf("--benchmark-step");
+    if (benchmarkIndex > 0) {
+        bool identical = true;
+        for (const QString& filename : arguments.mid(benchmarkIndex + 1)) {
+            identical = StepParser::benchmark(filename) && identical;
+        }
+        return identical ? 0 : 1;
+    }
+    
     qDebug() << "创建主窗口...";
     MainWindow window;
     qDebug() << "主窗口创建完成";